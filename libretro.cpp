@@ -1,15 +1,23 @@
 #include <stdarg.h>
+#include <assert.h>
 #include "mednafen/mednafen.h"
 #include "mednafen/mednafen-endian.h"
 #include "mednafen/mempatcher.h"
+#include "mednafen/lzstream.h"
 #include "mednafen/git.h"
 #include "mednafen/general.h"
 #include <libretro.h>
+#include "libretro_lynx.h"
 #include <streams/file_stream.h>
 #include <algorithm>
 #include "mednafen/lynx/system.h"
+#include "mednafen/lynx/rewind.h"
+#include "mednafen/lynx/fork.h"
+#include "mednafen/lynx/statehash.h"
 #include "libretro_core_options.h"
 
+#include <atomic>
+
 #ifdef _MSC_VER
 #include <compat/msvc.h>
 #endif
@@ -32,6 +40,8 @@ static retro_input_state_t input_state_cb;
 
 static bool overscan;
 static double last_sound_rate;
+static unsigned sound_rate = 44100;
+static bool audio_output_enabled = true;
 static MDFN_PixelFormat last_pixel_format;
 
 static unsigned rotate_mode;
@@ -55,6 +65,54 @@ static char retro_system_directory[4096];
 static bool libretro_supports_input_bitmasks;
 static int system_color_depth = 16;
 
+// Single producer (retro_run) single consumer (the embedder's audio thread)
+// ring of stereo frames. Each side only writes its own position and
+// counters, so neither needs a lock. Needs only <atomic>, so it is there
+// on every platform whether or not the core is built with threads.
+struct audio_ring
+{
+   int16_t *data;
+   size_t size;                     // frames, power of two
+   std::atomic<size_t> head;        // frames written, producer owned
+   std::atomic<size_t> tail;        // frames read, consumer owned
+   std::atomic<uint64_t> overruns;
+   std::atomic<uint64_t> overrun_frames;
+   std::atomic<uint64_t> underruns;
+   std::atomic<uint64_t> underrun_frames;
+};
+
+static audio_ring ring;
+
+static void audio_ring_push(const int16_t *src, size_t frames)
+{
+   size_t head  = ring.head.load(std::memory_order_relaxed);
+   size_t tail  = ring.tail.load(std::memory_order_acquire);
+   size_t count = std::min(frames, ring.size - (head - tail));
+   size_t pos   = head & (ring.size - 1);
+   size_t first = std::min(count, ring.size - pos);
+
+   memcpy(ring.data + pos * 2, src, first * 4);
+   memcpy(ring.data, src + first * 2, (count - first) * 4);
+   ring.head.store(head + count, std::memory_order_release);
+
+   if (count < frames)
+   {
+      ring.overruns.fetch_add(1, std::memory_order_relaxed);
+      ring.overrun_frames.fetch_add(frames - count, std::memory_order_relaxed);
+   }
+}
+
+// All sound leaves the core through here
+static void output_audio(const int16_t *data, size_t frames)
+{
+   if (ring.data)
+   {
+      audio_ring_push(data, frames);
+      return;
+   }
+   audio_batch_cb(data, frames);
+}
+
 extern MDFNGI EmulatedLynx;
 MDFNGI *MDFNGameInfo = &EmulatedLynx;
 
@@ -73,6 +131,64 @@ MDFNGI *MDFNGameInfo = &EmulatedLynx;
 
 #define FB_MAX_HEIGHT FB_HEIGHT
 
+// Frameskip, driven by the frontend's audio buffer occupancy
+#define FRAMESKIP_MAX 30
+
+static unsigned frameskip_type;             /* 0 off, 1 auto, 2 manual */
+static unsigned frameskip_threshold;
+static uint16_t frameskip_counter;
+
+static bool retro_audio_buff_active;
+static unsigned retro_audio_buff_occupancy;
+static bool retro_audio_buff_underrun;
+
+static unsigned audio_latency;
+static bool update_audio_latency;
+
+static void retro_audio_buff_status_cb(bool active, unsigned occupancy, bool underrun_likely)
+{
+   retro_audio_buff_active    = active;
+   retro_audio_buff_occupancy = occupancy;
+   retro_audio_buff_underrun  = underrun_likely;
+}
+
+static void init_frameskip(void)
+{
+   if (frameskip_type > 0)
+   {
+      struct retro_audio_buffer_status_callback buf_status_cb;
+
+      buf_status_cb.callback = retro_audio_buff_status_cb;
+      if (!environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &buf_status_cb))
+      {
+         if (log_cb)
+            log_cb(RETRO_LOG_WARN, "Frameskip disabled - frontend does not support audio buffer status monitoring.\n");
+
+         retro_audio_buff_active    = false;
+         retro_audio_buff_occupancy = 0;
+         retro_audio_buff_underrun  = false;
+         audio_latency              = 0;
+      }
+      else
+      {
+         /* Frameskip is enabled, raise the frontend audio latency to
+          * 6 frames (rounded up to a multiple of 32ms) so that skipping
+          * has some buffer to work with */
+         float frame_time_msec = 1000.0f / MEDNAFEN_CORE_TIMING_FPS;
+
+         audio_latency = (unsigned)((6.0f * frame_time_msec) + 0.5f);
+         audio_latency = (audio_latency + 0x1F) & ~0x1F;
+      }
+   }
+   else
+   {
+      environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, NULL);
+      audio_latency = 0;
+   }
+
+   update_audio_latency = true;
+}
+
 const char *mednafen_core_str = MEDNAFEN_CORE_NAME;
 
 static void check_system_specs(void)
@@ -108,9 +224,12 @@ void retro_init(void)
       libretro_supports_input_bitmasks = true;
 }
 
+static bool movie_reset_pending;
+
 void retro_reset(void)
 {
    DoSimpleCommand(MDFN_MSC_RESET);
+   movie_reset_pending = true;
 }
 
 bool retro_load_game_special(unsigned, const struct retro_game_info *, size_t)
@@ -128,6 +247,20 @@ static void set_volume (uint32_t *ptr, unsigned number)
    }
 }
 
+static CRewind *rewind_buf;
+static unsigned rewind_budget;
+static bool rewind_stepped;
+
+static void rewind_set_budget(unsigned mb)
+{
+   if (mb == rewind_budget)
+      return;
+
+   delete rewind_buf;
+   rewind_buf    = mb ? new CRewind(mb << 20) : NULL;
+   rewind_budget = mb;
+}
+
 static void check_variables(void)
 {
    struct retro_variable var = {0};
@@ -170,6 +303,69 @@ static void check_variables(void)
          rotate_fixed  = 3;
       }
    }
+
+   var.key = "lynx_sample_rate";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      sound_rate = strtoul(var.value, NULL, 10);
+
+   var.key = "lynx_collision_plane";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      lynxie->SetCollisionPlane(strcmp(var.value, "enabled") == 0);
+
+   var.key = "lynx_frameskip";
+   var.value = NULL;
+
+   frameskip_type = 0;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "auto") == 0)
+         frameskip_type = 1;
+      else if (strcmp(var.value, "manual") == 0)
+         frameskip_type = 2;
+   }
+
+   var.key = "lynx_frameskip_threshold";
+   var.value = NULL;
+
+   frameskip_threshold = 33;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      frameskip_threshold = strtol(var.value, NULL, 10);
+
+   var.key = "lynx_audio_sync";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      lynxie->SetAudioSyncLines(strcmp(var.value, "disabled") == 0 ? 0 : atoi(var.value));
+
+   var.key = "lynx_lazy_audio";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      lynxie->SetLazyAudio(strcmp(var.value, "enabled") == 0);
+
+   var.key = "lynx_rewind_buffer";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      rewind_set_budget(strcmp(var.value, "disabled") == 0 ? 0 : atoi(var.value));
+
+#ifdef WANT_THREADING
+   var.key = "lynx_sprite_thread";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      lynxie->SetSpriteThread(strcmp(var.value, "enabled") == 0);
+
+   var.key = "lynx_sprite_bands";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      lynxie->SetSpriteBands(strcmp(var.value, "disabled") == 0 ? 1 : atoi(var.value));
+#endif
 }
 
 #define MAX_PLAYERS 1
@@ -253,6 +449,15 @@ static bool init_pix_format(void)
 }
 
 
+/* The layout of a Lynx state only depends on the loaded cart, so its
+ * size is counted once per game without writing anything. That count also
+ * keeps the section sizes retro_lynx_save_state_compressed() streams. */
+static size_t serialize_size;
+
+/* Raw snapshots for retro_lynx_fast_state_*(), same idea */
+static uint32_t fast_state_size;
+static uint64_t fast_state_layout;
+
 bool retro_load_game(const struct retro_game_info *info)
 {
    if (!info || failed_init)
@@ -312,6 +517,10 @@ bool retro_load_game(const struct retro_game_info *info)
    rotate_screen_last_frame = 0;
 
    check_variables();
+   init_frameskip();
+
+   serialize_size = MDFNSS_CountSM();
+   fast_state_layout = MDFNSS_RawLayout(&fast_state_size);
 
    return true;
 }
@@ -331,9 +540,23 @@ static void MDFNI_CloseGame(void)
 }
 
 
+static CForkStore *fork_store;
+static CStateHash *state_hasher;
+
 void retro_unload_game(void)
 {
+   retro_lynx_movie_stop(NULL, NULL);
+   if (fork_store)
+      fork_store->Release();
+   fork_store = NULL;
+   delete state_hasher;
+   state_hasher = NULL;
+   rewind_set_budget(0);
    MDFNI_CloseGame();
+   serialize_size = 0;
+   fast_state_size = 0;
+   /* The next game's sound buffers are set up on its first frame */
+   last_sound_rate = 0;
 }
 
 static void update_input(void)
@@ -445,20 +668,68 @@ static void update_input(void)
    rotate_screen_last_frame  = rotate_screen;
 }
 
+static void movie_begin_frame(void);
+static void movie_end_frame(void);
+
 void retro_run()
 {
    input_poll_cb();
 
    update_input();
+   movie_begin_frame();
 
-   static int16_t sound_buf[0x10000];
+   // One frame of the longest length at 96kHz, stereo
+   static int16_t sound_buf[0x4000];
    static MDFN_Rect rects[FB_MAX_HEIGHT];
    rects[0].w = ~0;
 
+   // Bits 0/1 clear: the frontend throws this frame's video/audio away,
+   // e.g. for the hidden frames of run-ahead
+   int av_enable = 3;
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+      av_enable = 3;
+
+   bool video_enabled = (av_enable & 1);
+   bool audio_enabled = audio_output_enabled && (av_enable & 2);
+   bool skip_frame    = false;
+
+   if (frameskip_type > 0 && retro_audio_buff_active && video_enabled)
+   {
+      switch (frameskip_type)
+      {
+         case 1: /* auto */
+            skip_frame = retro_audio_buff_underrun;
+            break;
+         case 2: /* manual */
+            skip_frame = (retro_audio_buff_occupancy < frameskip_threshold);
+            break;
+      }
+
+      if (skip_frame)
+      {
+         if (frameskip_counter < FRAMESKIP_MAX)
+            frameskip_counter++;
+         else
+         {
+            /* Show at least one frame in every FRAMESKIP_MAX + 1 */
+            skip_frame        = false;
+            frameskip_counter = 0;
+         }
+      }
+      else
+         frameskip_counter = 0;
+   }
+
+   if (update_audio_latency)
+   {
+      environ_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &audio_latency);
+      update_audio_latency = false;
+   }
+
    EmulateSpecStruct spec = {0};
    spec.surface = surf;
-   spec.SoundRate = 44100;
-   spec.SoundBuf = sound_buf;
+   spec.SoundRate = sound_rate;
+   spec.SoundBuf = audio_enabled ? sound_buf : NULL;
    spec.LineWidths = rects;
    spec.SoundBufMaxSize = sizeof(sound_buf) / 2;
    spec.SoundVolume = 1.0;
@@ -466,6 +737,7 @@ void retro_run()
    spec.SoundBufSize = 0;
    spec.VideoFormatChanged = false;
    spec.SoundFormatChanged = false;
+   spec.skip = !video_enabled || skip_frame;
 
    if (spec.SoundRate != last_sound_rate)
    {
@@ -475,23 +747,51 @@ void retro_run()
 
    Emulate(&spec);
 
+   movie_end_frame();
+
+   /* Hidden run-ahead frames and the frame run after a step back are
+    * not history */
+   if (rewind_buf)
+   {
+      if (video_enabled && !rewind_stepped)
+         rewind_buf->Capture();
+      rewind_stepped = false;
+   }
+
+   // Sound up to the last mid-frame sync has been sent already
    int16 *const SoundBuf = spec.SoundBuf + spec.SoundBufSizeALMS * 2;
    int32 SoundBufSize = spec.SoundBufSize - spec.SoundBufSizeALMS;
-   const int32 SoundBufMaxSize = spec.SoundBufMaxSize - spec.SoundBufSizeALMS;
-
-   spec.SoundBufSize = spec.SoundBufSizeALMS + SoundBufSize;
 
    unsigned width  = spec.DisplayRect.w;
    unsigned height = spec.DisplayRect.h;
    unsigned pitch  = FB_WIDTH << (system_color_depth >> 4);
 
-   video_cb(surf->pixels, width, height, pitch);
+   if (skip_frame)
+      video_cb(NULL, width, height, pitch);
+   else if (video_enabled)
+      video_cb(surf->pixels, width, height, pitch);
 
-   audio_batch_cb(spec.SoundBuf, spec.SoundBufSize);
+   if (audio_enabled && SoundBufSize)
+      output_audio(SoundBuf, SoundBufSize);
 
    bool updated = false;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
+   {
+      unsigned old_sound_rate     = sound_rate;
+      unsigned old_frameskip_type = frameskip_type;
+
       check_variables();
+
+      if (frameskip_type != old_frameskip_type)
+         init_frameskip();
+
+      if (sound_rate != old_sound_rate)
+      {
+         struct retro_system_av_info av_info;
+         retro_get_system_av_info(&av_info);
+         environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &av_info);
+      }
+   }
 }
 
 void retro_get_system_info(struct retro_system_info *info)
@@ -511,7 +811,7 @@ void retro_get_system_av_info(struct retro_system_av_info *info)
 {
    memset(info, 0, sizeof(*info));
    info->timing.fps            = MEDNAFEN_CORE_TIMING_FPS;
-   info->timing.sample_rate    = 44100.0;
+   info->timing.sample_rate    = sound_rate;
    info->geometry.base_width   = MEDNAFEN_CORE_GEOMETRY_BASE_W;
    info->geometry.base_height  = MEDNAFEN_CORE_GEOMETRY_BASE_H;
    info->geometry.max_width    = MEDNAFEN_CORE_GEOMETRY_MAX_W;
@@ -532,6 +832,8 @@ void retro_deinit(void)
    }
 
    libretro_supports_input_bitmasks = false;
+
+   retro_lynx_audio_ring_init(0);
 }
 
 unsigned retro_get_region(void)
@@ -586,60 +888,437 @@ void retro_set_video_refresh(retro_video_refresh_t cb)
    video_cb = cb;
 }
 
-static size_t serialize_size;
-
 size_t retro_serialize_size(void)
+{
+   return serialize_size;
+}
+
+bool retro_serialize(void *data, size_t size)
 {
    StateMem st;
 
-   st.data           = NULL;
-   st.loc            = 0;
-   st.len            = 0;
-   st.malloced       = 0;
-   st.initial_malloc = 0;
+   /* Written straight into the frontend's buffer, a state that does
+    * not fit fails rather than growing it. */
+   memset(&st, 0, sizeof(st));
+   st.data           = (uint8_t*)data;
+   st.malloced       = size;
+   st.fixed          = 1;
 
    if (!MDFNSS_SaveSM(&st, 0, 0, NULL, NULL, NULL))
-      return 0;
+      return false;
 
-   free(st.data);
+   assert(st.len == serialize_size);
 
-   return serialize_size = st.len;
+   return true;
 }
 
-bool retro_serialize(void *data, size_t size)
+struct state_stream
+{
+   retro_lynx_state_write_t write;
+   retro_lynx_state_read_t read;
+   void *opaque;
+   const uint8_t *data;
+   size_t left;
+};
+
+static bool state_stream_write(void *opaque, const uint8_t *buffer, uint32_t len)
+{
+   struct state_stream *s = (struct state_stream*)opaque;
+   return s->write(s->opaque, buffer, len);
+}
+
+static uint32_t state_stream_read(void *opaque, uint8_t *buffer, uint32_t len)
+{
+   struct state_stream *s = (struct state_stream*)opaque;
+   return s->read(s->opaque, buffer, len);
+}
+
+static uint32_t state_memory_read(void *opaque, uint8_t *buffer, uint32_t len)
+{
+   struct state_stream *s = (struct state_stream*)opaque;
+
+   if (len > s->left)
+      len = s->left;
+   memcpy(buffer, s->data, len);
+   s->data += len;
+   s->left -= len;
+   return len;
+}
+
+/* Loads an LZS stream, the state is decoded a block at a time as the
+ * sections are read */
+static bool load_state_lzs(uint32_t (*read)(void *opaque, uint8_t *buffer, uint32_t len), void *opaque)
 {
    StateMem st;
-   bool ret          = false;
-   uint8_t *_dat     = (uint8_t*)malloc(size);
+   LZSReader *r = (LZSReader*)malloc(sizeof(LZSReader));
+   bool ret;
 
-   if (!_dat)
+   if (!r)
       return false;
 
-   /* Mednafen can realloc the buffer so we need to ensure this is safe. */
-   st.data           = _dat;
-   st.loc            = 0;
-   st.len            = 0;
-   st.malloced       = size;
-   st.initial_malloc = 0;
+   LZS_ReaderInit(r, read, opaque);
 
-   ret = MDFNSS_SaveSM(&st, 0, 0, NULL, NULL, NULL);
+   memset(&st, 0, sizeof(st));
+   st.read   = LZS_Read;
+   st.opaque = r;
 
-   memcpy(data, st.data, size);
-   free(st.data);
+   ret = MDFNSS_LoadSM(&st, 0, 0);
 
+   free(r);
    return ret;
 }
 
 bool retro_unserialize(const void *data, size_t size)
 {
    StateMem st;
+
+   if (LZS_IsStream((const uint8_t*)data, size))
+   {
+      struct state_stream s = {0};
+      s.data = (const uint8_t*)data;
+      s.left = size;
+      return load_state_lzs(state_memory_read, &s);
+   }
+
    memset(&st, 0, sizeof(st));
+   /* Read in place, the fields are copied straight out of data */
    st.data = (uint8_t*)data;
    st.len  = size;
 
    return MDFNSS_LoadSM(&st, 0, 0);
 }
 
+bool retro_lynx_save_state_compressed(retro_lynx_state_write_t write, void *opaque)
+{
+   StateMem st;
+   struct state_stream s = {0};
+   LZSWriter *w;
+   bool ret;
+
+   if (!lynxie || !write)
+      return false;
+
+   w = (LZSWriter*)malloc(sizeof(LZSWriter));
+   if (!w)
+      return false;
+
+   s.write  = write;
+   s.opaque = opaque;
+   LZS_WriterInit(w, state_stream_write, &s);
+
+   memset(&st, 0, sizeof(st));
+   st.write  = LZS_Write;
+   st.opaque = w;
+
+   ret = MDFNSS_SaveSM(&st, 0, 0, NULL, NULL, NULL) && LZS_WriterFinish(w);
+
+   free(w);
+   return ret;
+}
+
+bool retro_lynx_load_state_compressed(retro_lynx_state_read_t read, void *opaque)
+{
+   struct state_stream s = {0};
+
+   if (!lynxie || !read)
+      return false;
+
+   s.read   = read;
+   s.opaque = opaque;
+   return load_state_lzs(state_stream_read, &s);
+}
+
+/* Input movies
+ *
+ *  0  "LYNXMOV1"
+ *  8  uint32 hash interval in frames
+ * 12  uint32 frame count
+ * 16  uint32 game CRC32
+ * 20  uint32 anchor length
+ * 24  anchor state, an LZS stream
+ *     then per frame the uint16 button data, bit 15 set for a reset
+ *     before the frame, and after every hash interval frames the uint64
+ *     state hash at the end of the frame
+ *
+ * All little endian. */
+#define MOVIE_HEADER_SIZE  24
+#define MOVIE_RESET        0x8000
+
+enum
+{
+   MOVIE_OFF = 0,
+   MOVIE_RECORD,
+   MOVIE_PLAY
+};
+
+static struct
+{
+   int mode;
+   uint8_t *data;
+   size_t size;
+   size_t alloced;
+   size_t pos;
+   uint32_t frame;
+   uint32_t frames;
+   uint32_t hash_interval;
+   uint32_t desyncs;
+   uint32_t first_desync;
+} movie;
+
+static bool movie_append(const void *data, size_t len)
+{
+   if (movie.size + len > movie.alloced)
+   {
+      size_t alloced = movie.alloced ? movie.alloced : 65536;
+      uint8_t *grown;
+
+      while (movie.size + len > alloced)
+         alloced *= 2;
+      grown = (uint8_t*)realloc(movie.data, alloced);
+      if (!grown)
+         return false;
+      movie.data    = grown;
+      movie.alloced = alloced;
+   }
+   memcpy(movie.data + movie.size, data, len);
+   movie.size += len;
+   return true;
+}
+
+static bool RETRO_CALLCONV movie_append_cb(void *opaque, const void *data, size_t len)
+{
+   return movie_append(data, len);
+}
+
+static void movie_begin_frame(void)
+{
+   uint16_t buttons;
+
+   if (movie.mode == MOVIE_RECORD)
+   {
+      uint8_t rec[2];
+
+      buttons = input_buf[0] | (input_buf[1] << 8);
+      if (movie_reset_pending)
+         buttons |= MOVIE_RESET;
+      MDFN_en16lsb(rec, buttons);
+      movie_append(rec, 2);
+   }
+   else if (movie.mode == MOVIE_PLAY)
+   {
+      if (movie.frame == movie.frames || movie.pos + 2 > movie.size)
+      {
+         movie.mode = MOVIE_OFF;
+         return;
+      }
+
+      buttons = MDFN_de16lsb(movie.data + movie.pos);
+      movie.pos += 2;
+      if (buttons & MOVIE_RESET)
+         DoSimpleCommand(MDFN_MSC_RESET);
+      input_buf[0] = buttons & 0xff;
+      input_buf[1] = (buttons >> 8) & 0x7f;
+   }
+
+   movie_reset_pending = false;
+}
+
+static void movie_end_frame(void)
+{
+   if (movie.mode == MOVIE_OFF)
+      return;
+
+   movie.frame++;
+
+   if (movie.frame % movie.hash_interval)
+      return;
+
+   if (movie.mode == MOVIE_RECORD)
+   {
+      uint8_t rec[8];
+      MDFN_en64lsb(rec, retro_lynx_state_hash());
+      movie_append(rec, 8);
+   }
+   else if (movie.pos + 8 <= movie.size)
+   {
+      if (MDFN_de64lsb(movie.data + movie.pos) != retro_lynx_state_hash())
+      {
+         if (!movie.desyncs)
+            movie.first_desync = movie.frame;
+         movie.desyncs++;
+      }
+      movie.pos += 8;
+   }
+}
+
+bool retro_lynx_movie_record(bool power_on, unsigned hash_interval)
+{
+   uint8_t header[MOVIE_HEADER_SIZE];
+   StateMem st;
+   LZSWriter *w;
+   bool ret;
+
+   if (!lynxie)
+      return false;
+
+   retro_lynx_movie_stop(NULL, NULL);
+
+   if (power_on)
+      DoSimpleCommand(MDFN_MSC_RESET);
+
+   memset(header, 0, sizeof(header));
+   memcpy(header, "LYNXMOV1", 8);
+   MDFN_en32lsb(header + 8, hash_interval ? hash_interval : 60);
+   MDFN_en32lsb(header + 16, lynxie->CRC32());
+
+   movie.size = 0;
+   if (!movie_append(header, sizeof(header)))
+      return false;
+
+   w = (LZSWriter*)malloc(sizeof(LZSWriter));
+   if (!w)
+      return false;
+
+   {
+      struct state_stream s = {0};
+      s.write = movie_append_cb;
+      LZS_WriterInit(w, state_stream_write, &s);
+
+      memset(&st, 0, sizeof(st));
+      st.write  = LZS_Write;
+      st.opaque = w;
+
+      ret = MDFNSS_SaveSM(&st, 0, 0, NULL, NULL, NULL) && LZS_WriterFinish(w);
+   }
+   free(w);
+
+   if (!ret)
+      return false;
+
+   MDFN_en32lsb(movie.data + 20, movie.size - MOVIE_HEADER_SIZE);
+
+   movie.mode          = MOVIE_RECORD;
+   movie.frame         = 0;
+   movie.hash_interval = hash_interval ? hash_interval : 60;
+   movie_reset_pending = false;
+   return true;
+}
+
+bool retro_lynx_movie_stop(retro_lynx_state_write_t write, void *opaque)
+{
+   bool ret = true;
+
+   if (movie.mode == MOVIE_RECORD)
+   {
+      MDFN_en32lsb(movie.data + 12, movie.frame);
+      if (write)
+         ret = write(opaque, movie.data, movie.size);
+   }
+   else if (write)
+      ret = false;
+
+   movie.mode = MOVIE_OFF;
+   free(movie.data);
+   movie.data    = NULL;
+   movie.size    = 0;
+   movie.alloced = 0;
+   return ret;
+}
+
+bool retro_lynx_movie_play(const void *data, size_t size)
+{
+   const uint8_t *in = (const uint8_t*)data;
+   uint32_t anchor_size;
+
+   if (!lynxie || size < MOVIE_HEADER_SIZE || memcmp(in, "LYNXMOV1", 8))
+      return false;
+
+   anchor_size = MDFN_de32lsb(in + 20);
+   if (MDFN_de32lsb(in + 8) == 0 || MDFN_de32lsb(in + 16) != lynxie->CRC32()
+         || anchor_size > size - MOVIE_HEADER_SIZE)
+      return false;
+
+   retro_lynx_movie_stop(NULL, NULL);
+
+   {
+      struct state_stream s = {0};
+      s.data = in + MOVIE_HEADER_SIZE;
+      s.left = anchor_size;
+      if (!load_state_lzs(state_memory_read, &s))
+         return false;
+   }
+
+   movie.size = 0;
+   if (!movie_append(data, size))
+      return false;
+
+   movie.mode          = MOVIE_PLAY;
+   movie.pos           = MOVIE_HEADER_SIZE + anchor_size;
+   movie.frame         = 0;
+   movie.frames        = MDFN_de32lsb(in + 12);
+   movie.hash_interval = MDFN_de32lsb(in + 8);
+   movie.desyncs       = 0;
+   movie.first_desync  = 0;
+   return true;
+}
+
+bool retro_lynx_movie_get_status(struct retro_lynx_movie_status *status)
+{
+   if (!status)
+      return false;
+
+   status->mode         = movie.mode;
+   status->frame        = movie.frame;
+   status->frames       = movie.mode == MOVIE_PLAY ? movie.frames : movie.frame;
+   status->desyncs      = movie.desyncs;
+   status->first_desync = movie.first_desync;
+   return true;
+}
+
+uint64_t retro_lynx_state_hash(void)
+{
+   if (!lynxie)
+      return 0;
+
+   if (!state_hasher)
+      state_hasher = new CStateHash();
+   return state_hasher->Hash();
+}
+
+size_t retro_lynx_fast_state_size(void)
+{
+   return fast_state_size;
+}
+
+bool retro_lynx_fast_state_save(void *data, size_t size)
+{
+   StateMem st;
+
+   if (!fast_state_size || size < fast_state_size)
+      return false;
+
+   memset(&st, 0, sizeof(st));
+   st.data     = (uint8_t*)data;
+   st.malloced = fast_state_size;
+   st.fixed    = 1;
+
+   return MDFNSS_SaveRawSM(&st, fast_state_layout);
+}
+
+bool retro_lynx_fast_state_load(const void *data, size_t size)
+{
+   StateMem st;
+
+   if (!fast_state_size || size < fast_state_size)
+      return false;
+
+   memset(&st, 0, sizeof(st));
+   st.data = (uint8_t*)data;
+   st.len  = fast_state_size;
+
+   return MDFNSS_LoadRawSM(&st, fast_state_layout);
+}
+
 void *retro_get_memory_data(unsigned type)
 {
    if (lynxie && type == RETRO_MEMORY_SYSTEM_RAM)
@@ -654,6 +1333,184 @@ size_t retro_get_memory_size(unsigned type)
    return 0;
 }
 
+bool retro_lynx_rewind_step_back(void)
+{
+   if (!rewind_buf || !rewind_buf->StepBack())
+      return false;
+   rewind_stepped = true;
+   return true;
+}
+
+bool retro_lynx_rewind_get_stats(struct retro_lynx_rewind_stats *stats)
+{
+   if (!rewind_buf || !stats)
+      return false;
+
+   stats->frames = rewind_buf->Frames();
+   stats->bytes  = rewind_buf->BytesUsed();
+   stats->budget = (size_t)rewind_budget << 20;
+   return true;
+}
+
+struct retro_lynx_fork *retro_lynx_fork_save(void)
+{
+   if (!lynxie)
+      return NULL;
+   if (!fork_store)
+      fork_store = new CForkStore();
+   return (struct retro_lynx_fork*)fork_store->Save();
+}
+
+bool retro_lynx_fork_load(const struct retro_lynx_fork *fork)
+{
+   if (!fork_store || !fork)
+      return false;
+   return fork_store->Load((const TFORK*)fork);
+}
+
+void retro_lynx_fork_free(struct retro_lynx_fork *fork)
+{
+   CForkStore::Free((TFORK*)fork);
+}
+
+size_t retro_lynx_fork_pages(void)
+{
+   return fork_store ? fork_store->PagesInUse() : 0;
+}
+
+uint32_t retro_lynx_ram_dirty_mark(void)
+{
+   if (!lynxie)
+      return 0;
+   return lynxie->mRam->DirtyMark();
+}
+
+unsigned retro_lynx_ram_dirty_pages(uint32_t mark, uint8_t *bitmap)
+{
+   if (!lynxie)
+      return 0;
+   return lynxie->mRam->GetDirtyPages(mark, bitmap);
+}
+
+void retro_lynx_ram_mark_dirty(void)
+{
+   if (lynxie)
+      lynxie->mRam->MarkAllDirty();
+}
+
+bool retro_lynx_get_suzy_stats(struct retro_lynx_suzy_stats *stats)
+{
+#ifdef WANT_SUZY_STATS
+   TSUZYSTATS frame;
+
+   if (!lynxie || !stats)
+      return false;
+
+   lynxie->mSusie->GetStats(&frame);
+
+   stats->scbs        = frame.scbs;
+   stats->skipped     = frame.skipped;
+   for (unsigned i = 0; i < 8; i++)
+      stats->drawn[i] = frame.drawn[i];
+   stats->pixels      = frame.pixels;
+   stats->coll_reads  = frame.coll_reads;
+   stats->coll_writes = frame.coll_writes;
+   stats->bytes       = frame.bytes;
+   stats->cycles      = frame.cycles;
+   return true;
+#else
+   return false;
+#endif
+}
+
+void retro_lynx_set_audio_enabled(bool enable)
+{
+   audio_output_enabled = enable;
+}
+
+void retro_lynx_set_voice_output(bool enable)
+{
+   if (lynxie)
+      lynxie->mMikie->SetVoiceOutput(enable);
+}
+
+size_t retro_lynx_read_voice_samples(unsigned voice, int16_t *out, size_t max)
+{
+   if (!lynxie || !lynxie->mMikie->mVoiceOutput || voice >= 4 || !out)
+      return 0;
+
+   return lynxie->mMikie->ReadVoiceSamples(voice, out, max);
+}
+
+bool retro_lynx_audio_ring_init(size_t frames)
+{
+   size_t size = 1;
+
+   free(ring.data);
+   ring.data = NULL;
+   ring.size = 0;
+
+   if (frames)
+   {
+      while (size < frames)
+         size <<= 1;
+
+      ring.data = (int16_t*)malloc(size * 4);
+      if (!ring.data)
+         return false;
+      ring.size = size;
+   }
+
+   ring.head.store(0, std::memory_order_relaxed);
+   ring.tail.store(0, std::memory_order_relaxed);
+   ring.overruns.store(0, std::memory_order_relaxed);
+   ring.overrun_frames.store(0, std::memory_order_relaxed);
+   ring.underruns.store(0, std::memory_order_relaxed);
+   ring.underrun_frames.store(0, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   return true;
+}
+
+size_t retro_lynx_audio_ring_read(int16_t *out, size_t frames)
+{
+   if (!ring.data)
+      return 0;
+
+   size_t tail  = ring.tail.load(std::memory_order_relaxed);
+   size_t head  = ring.head.load(std::memory_order_acquire);
+   size_t count = std::min(frames, head - tail);
+   size_t pos   = tail & (ring.size - 1);
+   size_t first = std::min(count, ring.size - pos);
+
+   memcpy(out, ring.data + pos * 2, first * 4);
+   memcpy(out + first * 2, ring.data, (count - first) * 4);
+   ring.tail.store(tail + count, std::memory_order_release);
+
+   if (count < frames)
+   {
+      ring.underruns.fetch_add(1, std::memory_order_relaxed);
+      ring.underrun_frames.fetch_add(frames - count, std::memory_order_relaxed);
+   }
+   return count;
+}
+
+bool retro_lynx_audio_ring_get_stats(struct retro_lynx_audio_ring_stats *stats)
+{
+   if (!ring.data || !stats)
+      return false;
+
+   size_t head = ring.head.load(std::memory_order_acquire);
+   size_t tail = ring.tail.load(std::memory_order_acquire);
+
+   stats->size            = ring.size;
+   stats->queued          = head - tail;
+   stats->overruns        = ring.overruns.load(std::memory_order_relaxed);
+   stats->overrun_frames  = ring.overrun_frames.load(std::memory_order_relaxed);
+   stats->underruns       = ring.underruns.load(std::memory_order_relaxed);
+   stats->underrun_frames = ring.underrun_frames.load(std::memory_order_relaxed);
+   return true;
+}
+
 void retro_cheat_reset(void)
 {}
 
@@ -676,8 +1533,19 @@ void MDFND_DispMessage(unsigned char *str)
       log_cb(RETRO_LOG_INFO, "%s", str);
 }
 
-void MDFND_MidSync(const EmulateSpecStruct *)
-{}
+void MDFND_MidSync(const EmulateSpecStruct *espec)
+{
+   if (espec->SoundBuf && espec->SoundBufSize > espec->SoundBufSizeALMS)
+      output_audio(espec->SoundBuf + espec->SoundBufSizeALMS * 2, espec->SoundBufSize - espec->SoundBufSizeALMS);
+}
+
+void MDFN_MidSync(EmulateSpecStruct *espec)
+{
+   MDFND_MidSync(espec);
+
+   espec->SoundBufSizeALMS = espec->SoundBufSize;
+   espec->MasterCyclesALMS = espec->MasterCycles;
+}
 
 void MDFN_MidLineUpdate(EmulateSpecStruct *espec, int y)
 {
@@ -94,6 +94,168 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       "16",
    },
 
+   {
+      "lynx_sample_rate",
+      "Audio Sample Rate",
+      NULL,
+      "Output sample rate. Sound is synthesised directly at this rate, matching the frontend's rate avoids resampling it a second time.",
+      NULL,
+      NULL,
+      {
+         { "22050", "22050 Hz" },
+         { "32000", "32000 Hz" },
+         { "44100", "44100 Hz" },
+         { "48000", "48000 Hz" },
+         { "96000", "96000 Hz" },
+         { NULL, NULL},
+      },
+      "44100",
+   },
+
+   {
+      "lynx_collision_plane",
+      "Fast Collision Buffer",
+      NULL,
+      "Keep an unpacked copy of the sprite collision buffer so colliding sprites are drawn in spans instead of pixel by pixel. Output is identical.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "enabled",  NULL },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+
+   {
+      "lynx_frameskip",
+      "Frameskip",
+      NULL,
+      "Skip frames to avoid audio buffer under-run (crackling). Improves performance at the expense of visual smoothness. 'Auto' skips frames when advised by the frontend. 'Manual' utilises the 'Frameskip Threshold (%)' setting.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "auto",     "Auto" },
+         { "manual",   "Manual" },
+         { NULL, NULL },
+      },
+      "disabled"
+   },
+   {
+      "lynx_frameskip_threshold",
+      "Frameskip Threshold (%)",
+      NULL,
+      "When 'Frameskip' is set to 'Manual', specifies the audio buffer occupancy threshold (percentage) below which frames will be skipped. Higher values reduce the risk of crackling by causing frames to be dropped more frequently.",
+      NULL,
+      NULL,
+      {
+         { "15", NULL },
+         { "18", NULL },
+         { "21", NULL },
+         { "24", NULL },
+         { "27", NULL },
+         { "30", NULL },
+         { "33", NULL },
+         { "36", NULL },
+         { "39", NULL },
+         { "42", NULL },
+         { "45", NULL },
+         { "48", NULL },
+         { "51", NULL },
+         { "54", NULL },
+         { "57", NULL },
+         { "60", NULL },
+         { NULL, NULL },
+      },
+      "33"
+   },
+
+   {
+      "lynx_audio_sync",
+      "Audio Sync Interval",
+      NULL,
+      "Send sound to the frontend every so many scanlines while the frame runs, instead of all at once when it ends. Lower and steadier audio latency with small audio buffers. A frame is 105 lines.",
+      NULL,
+      NULL,
+      {
+         { "disabled", "Once per frame" },
+         { "53",       "53 lines (2 per frame)" },
+         { "35",       "35 lines (3 per frame)" },
+         { "27",       "27 lines (4 per frame)" },
+         { "14",       "14 lines (8 per frame)" },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+
+   {
+      "lynx_lazy_audio",
+      "Lazy Audio Timers",
+      NULL,
+      "Step audio channels in bulk when their timers are needed instead of stopping the emulation at every waveform step. Each step lands on its exact cycle rather than the next timer update after it, so sound and timing differ very slightly from the default.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "enabled",  NULL },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+
+   {
+      "lynx_rewind_buffer",
+      "Core Rewind Buffer",
+      NULL,
+      "Memory for the core's own rewind history, recorded every frame as the changes from the frame before. A few MB hold minutes of play. Only used by frontends that step back through it with the Lynx extension API, the frontend's own rewind is not affected.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "4",        "4 MB" },
+         { "8",        "8 MB" },
+         { "16",       "16 MB" },
+         { "32",       "32 MB" },
+         { "64",       "64 MB" },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+
+#ifdef WANT_THREADING
+   {
+      "lynx_sprite_thread",
+      "Threaded Sprite Engine",
+      NULL,
+      "Run the Suzy sprite engine on a separate thread while the emulated CPU sleeps. Output is identical to the single threaded path.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "enabled",  NULL },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+   {
+      "lynx_sprite_bands",
+      "Banded Sprite Rendering (Experimental)",
+      NULL,
+      "Split sprite rendering across threads by screen lines. Falls back to the normal path for sprite lists that read back what they draw.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "2",        NULL },
+         { "3",        NULL },
+         { "4",        NULL },
+         { NULL, NULL},
+      },
+      "disabled",
+   },
+#endif
+
    { NULL, NULL, NULL, NULL, NULL, NULL, {{0}}, NULL },
 };
 
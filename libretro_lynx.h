@@ -0,0 +1,194 @@
+#ifndef LIBRETRO_LYNX_H__
+#define LIBRETRO_LYNX_H__
+
+/*
+ * Lynx specific extensions to the libretro API, for frontends and tools
+ * that load this core directly. All functions may be called between
+ * retro_load_game() and retro_unload_game() from the thread that calls
+ * retro_run().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <libretro.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Suzy sprite engine counters for the last frame run. */
+struct retro_lynx_suzy_stats
+{
+   uint32_t scbs;           /* SCBs fetched */
+   uint32_t skipped;        /* of which skip sprites */
+   uint32_t drawn[8];       /* sprites processed, by sprite type */
+   uint32_t pixels;         /* video pixel writes */
+   uint32_t coll_reads;     /* collision buffer reads */
+   uint32_t coll_writes;    /* collision buffer writes */
+   uint32_t bytes;          /* sprite data bytes fetched */
+   uint32_t cycles;         /* sprite engine cycles */
+};
+
+/* Returns false if the core was built without SUZY_STATS=1. */
+RETRO_API bool retro_lynx_get_suzy_stats(struct retro_lynx_suzy_stats *stats);
+
+/* With audio disabled no sound is synthesised or sent to the audio
+ * callback, the emulated sound hardware still runs so savestates are the
+ * same either way. Also implied by RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE.
+ * Enabled by default. */
+RETRO_API void retro_lynx_set_audio_enabled(bool enable);
+
+/* Per voice audio. When enabled each retro_run() also renders the four
+ * channel output levels (before stereo, pan and attenuation) into separate
+ * mono streams at the core's sample rate, in the same pass as the mix. */
+RETRO_API void retro_lynx_set_voice_output(bool enable);
+
+/* Reads up to max samples of voice 0-3 produced by the last retro_run().
+ * Samples not read before the next retro_run() are dropped. */
+RETRO_API size_t retro_lynx_read_voice_samples(unsigned voice, int16_t *out, size_t max);
+
+/* Audio ring. Instead of going to the audio callback every sample the
+ * core produces is queued in a lock-free single producer, single consumer
+ * ring buffer of stereo frames, to be pulled from another thread.
+ *
+ * retro_lynx_audio_ring_init() sizes the ring to at least the given
+ * number of frames (0 removes it and goes back to the callback), it must
+ * not run while the consumer is reading. Returns false on allocation
+ * failure.
+ *
+ * retro_lynx_audio_ring_read() and retro_lynx_audio_ring_get_stats() may
+ * be called from one other thread at the same time as retro_run(), they
+ * never block or allocate. A read returns the frames copied, a short read
+ * counts as an underrun. A frame that does not fit when retro_run()
+ * queues it is dropped and counted as an overrun. */
+struct retro_lynx_audio_ring_stats
+{
+   size_t size;                /* capacity in frames */
+   size_t queued;              /* frames waiting to be read */
+   uint64_t overruns;          /* pushes that did not fit */
+   uint64_t overrun_frames;    /* frames dropped by them */
+   uint64_t underruns;         /* reads that came up short */
+   uint64_t underrun_frames;   /* frames missing from them */
+};
+
+RETRO_API bool retro_lynx_audio_ring_init(size_t frames);
+RETRO_API size_t retro_lynx_audio_ring_read(int16_t *out, size_t frames);
+RETRO_API bool retro_lynx_audio_ring_get_stats(struct retro_lynx_audio_ring_stats *stats);
+
+/* Fast snapshots. A raw copy of the emulated state without the field
+ * names and sizes of the retro_serialize() format, for run-ahead,
+ * rollback or search within one process. A snapshot can only be loaded
+ * by the same build with the same game loaded, anything else is refused.
+ * The size is fixed while a game is loaded. */
+RETRO_API size_t retro_lynx_fast_state_size(void);
+RETRO_API bool retro_lynx_fast_state_save(void *data, size_t size);
+RETRO_API bool retro_lynx_fast_state_load(const void *data, size_t size);
+
+/* Forks, snapshots for tree search and speculative execution that share
+ * unchanged RAM with each other. A fork holds its RAM as 256 byte pages,
+ * a page is only copied when it was written since the fork last saved or
+ * loaded, so saving the state next to a recent fork costs a few pages
+ * plus the few KB of registers (more if the cart has RAM). Loading
+ * copies only the pages that differ. Forks may be loaded any number of
+ * times in any order, but only into the game they were saved in; a fork
+ * still held at retro_unload_game() can no longer be loaded and must
+ * still be freed. None of these may be called from more than one thread.
+ * retro_lynx_fork_pages() is the number of RAM pages held by all forks. */
+struct retro_lynx_fork;
+
+RETRO_API struct retro_lynx_fork *retro_lynx_fork_save(void);
+RETRO_API bool retro_lynx_fork_load(const struct retro_lynx_fork *fork);
+RETRO_API void retro_lynx_fork_free(struct retro_lynx_fork *fork);
+RETRO_API size_t retro_lynx_fork_pages(void);
+
+/* RAM dirty pages. Every write to the 64KB of RAM, by the CPU, Suzy,
+ * cheats, reset or a state load, records the page it lands in.
+ * retro_lynx_ram_dirty_mark() returns a mark, a later
+ * retro_lynx_ram_dirty_pages() call with it sets a bit (LSB first) in
+ * bitmap for each page written since and returns how many there are.
+ * Any number of marks can be in use at once. Writes a frontend makes
+ * through retro_get_memory_data() are not seen, call
+ * retro_lynx_ram_mark_dirty() after them. */
+#define RETRO_LYNX_RAM_PAGE_SIZE 256
+#define RETRO_LYNX_RAM_PAGES     256
+
+RETRO_API uint32_t retro_lynx_ram_dirty_mark(void);
+RETRO_API unsigned retro_lynx_ram_dirty_pages(uint32_t mark, uint8_t *bitmap);
+RETRO_API void retro_lynx_ram_mark_dirty(void);
+
+/* Compressed savestates. The same state as retro_serialize(), LZ coded a
+ * block of 32KB at a time as it is produced and handed to write in
+ * pieces, the uncompressed state is never held whole. Loading reads it
+ * back through read the same way, read returns how many bytes it gave,
+ * less than asked for only at the end of the data. retro_unserialize()
+ * also accepts a compressed state held in memory. write returning false
+ * or a short or damaged read fails the call; a failed load may leave
+ * the state partly loaded, as with retro_unserialize(). */
+typedef bool (RETRO_CALLCONV *retro_lynx_state_write_t)(void *opaque, const void *data, size_t len);
+typedef size_t (RETRO_CALLCONV *retro_lynx_state_read_t)(void *opaque, void *data, size_t len);
+
+RETRO_API bool retro_lynx_save_state_compressed(retro_lynx_state_write_t write, void *opaque);
+RETRO_API bool retro_lynx_load_state_compressed(retro_lynx_state_read_t read, void *opaque);
+
+/* 64 bit hash of the whole emulated state, for netplay peers and movies
+ * to compare every frame instead of whole savestates. RAM pages are only
+ * hashed again once written, a call costs a few microseconds. Equal
+ * states hash the same in builds of the same version on the same
+ * platform. 0 with no game loaded. */
+RETRO_API uint64_t retro_lynx_state_hash(void);
+
+/* Input movies, for reproducible runs of real games. A movie is a
+ * compressed savestate anchor, the button data of every frame and a
+ * state hash every hash_interval frames (default 60) to catch desyncs.
+ *
+ * retro_lynx_movie_record() starts recording from the current state, or
+ * from a reset with power_on, and retro_lynx_movie_stop() ends it and
+ * hands the movie to write (NULL throws it away). Resets between are
+ * recorded. retro_lynx_movie_play() refuses a movie of another game,
+ * loads the anchor and feeds the movie's buttons to the following
+ * retro_run() calls in place of the input callback, until it runs out or
+ * is stopped. Hash mismatches are counted. Frontend features that run
+ * frames again, run-ahead, rollback or rewind, do not mix with either. */
+enum
+{
+   RETRO_LYNX_MOVIE_OFF = 0,
+   RETRO_LYNX_MOVIE_RECORD,
+   RETRO_LYNX_MOVIE_PLAY
+};
+
+struct retro_lynx_movie_status
+{
+   unsigned mode;              /* RETRO_LYNX_MOVIE_* */
+   unsigned frame;             /* frames recorded or played */
+   unsigned frames;            /* length of the movie being played */
+   unsigned desyncs;           /* state hashes that did not match */
+   unsigned first_desync;      /* frame of the first of them */
+};
+
+RETRO_API bool retro_lynx_movie_record(bool power_on, unsigned hash_interval);
+RETRO_API bool retro_lynx_movie_stop(retro_lynx_state_write_t write, void *opaque);
+RETRO_API bool retro_lynx_movie_play(const void *data, size_t size);
+RETRO_API bool retro_lynx_movie_get_status(struct retro_lynx_movie_status *status);
+
+/* Core rewind, sized by the lynx_rewind_buffer core option. Every
+ * retro_run() with video enabled is recorded. Stepping back loads the
+ * frame before the newest one recorded and drops it from the history. The
+ * retro_run() that follows is not recorded, so stepping back before every
+ * retro_run() goes back one frame per frame. Returns false when there is
+ * no further history or the option is disabled. */
+struct retro_lynx_rewind_stats
+{
+   unsigned frames;            /* steps back available */
+   size_t bytes;               /* buffer used by them */
+   size_t budget;              /* buffer size */
+};
+
+RETRO_API bool retro_lynx_rewind_step_back(void);
+RETRO_API bool retro_lynx_rewind_get_stats(struct retro_lynx_rewind_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -65,7 +65,7 @@
 
 #define CPU_PEEK(m)				(((m<0xfc00)?mRamPointer[m]:mSystem.Peek_CPU(m)))
 #define CPU_PEEKW(m)			(((m<0xfc00)?(mRamPointer[m]+(mRamPointer[m+1]<<8)):mSystem.PeekW_CPU(m)))
-#define CPU_POKE(m1,m2)			{if(m1<0xfc00) mRamPointer[m1]=m2; else mSystem.Poke_CPU(m1,m2);}
+#define CPU_POKE(m1,m2)			{if(m1<0xfc00) { mRamPointer[m1]=m2; mRamPages[(m1)>>RAM_PAGE_SHIFT]=gRamEpoch; } else mSystem.Poke_CPU(m1,m2);}
 
 
 enum {	illegal=0,
@@ -134,6 +134,7 @@ class C65C02
 		inline void Reset(void)
 		{
 			mRamPointer=mSystem.GetRamPointer();
+			mRamPages=mSystem.GetRamPagePointer();
 			mA=0;
 		    mX=0;
 		    mY=0;
@@ -238,6 +239,7 @@ class C65C02
 		int mIRQActive;
 
 		uint8 *mRamPointer;
+		uint32 *mRamPages;
 
 		// Associated lookup tables
 
@@ -218,6 +218,7 @@ CCart::CCart(MDFNFILE *fp)
 	mWriteEnableBank0=false;
 	mWriteEnableBank1=false;
 	mCartRAM=false;
+	mCartRamWrites=0;
 	mCRC32=0;
 
 	if(fp)
@@ -449,7 +450,11 @@ INLINE void CCart::Poke(uint32 addr, uint8 data)
 	}
 	else
 	{
-		if(mWriteEnableBank1) mCartBank1[addr&mMaskBank1]=data;
+		if(mWriteEnableBank1)
+		{
+			mCartBank1[addr&mMaskBank1]=data;
+			mCartRamWrites++;
+		}
 	}
 }
 
@@ -514,6 +519,7 @@ void CCart::Poke1(uint8 data)
 	{
 		uint32 address=(mShifter<<mShiftCount1)+(mCounter&mCountMask1);
 		mCartBank1[address&mMaskBank1]=data;
+		mCartRamWrites++;
 	}
 	if(!mStrobe)
 	{
@@ -573,6 +579,8 @@ int CCart::StateAction(StateMem *sm, int load, int data_only)
  };
  int ret = MDFNSS_StateAction(sm, load, data_only, CartRegs, "CART", false);
 
+ if(load)
+  mCartRamWrites++;
 
  return(ret);
 }
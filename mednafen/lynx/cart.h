@@ -104,6 +104,12 @@ class CCart : public CLynxBase
 		uint32	CartGetRotate(void) { return mRotation;};
 		uint32	CRC32(void) { return mCRC32; };
 
+// Writable bank 1 contents, NULL if there is none, and a count that
+// changes whenever they might have
+		uint8*	CartRamPointer(void) { return mCartRAM?mCartBank1:NULL; };
+		uint32	CartRamSize(void) { return mCartRAM?mMaskBank1+1:0; };
+		uint32	CartRamWrites(void) { return mCartRamWrites; };
+
 		int StateAction(StateMem *sm, int load, int data_only);
 
 // Access for the lynx itself, it has no idea of address etc as this is done by the
@@ -132,6 +138,7 @@ class CCart : public CLynxBase
 		char	mName[33];
 		char	mManufacturer[17];
 		uint32	mRotation;
+		uint32	mCartRamWrites;
 
 		uint32	mCounter;
 		uint32	mShifter;
@@ -0,0 +1,166 @@
+//////////////////////////////////////////////////////////////////////////////
+// Snapshot forks                                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "system.h"
+#include "fork.h"
+
+#include <stddef.h>
+
+CForkStore::CForkStore()
+	:mRefs(1),
+	mMark(0),
+	mFreePages(NULL),
+	mPagesInUse(0)
+{
+	uint32 size;
+
+	mLayout=MDFNSS_RawLayout(&size);
+	mRestSize=size-RAM_SIZE;
+
+	for(int loop=0;loop<RAM_PAGES;loop++)
+		mLive[loop]=NULL;
+}
+
+CForkStore::~CForkStore()
+{
+	while(mFreePages)
+	{
+		TFORKPAGE *page=mFreePages;
+		mFreePages=page->next_free;
+		delete page;
+	}
+}
+
+void CForkStore::Release(void)
+{
+	for(int loop=0;loop<RAM_PAGES;loop++)
+	{
+		if(mLive[loop])
+			Unref(mLive[loop]);
+		mLive[loop]=NULL;
+	}
+
+	if(!--mRefs)
+		delete this;
+}
+
+TFORKPAGE* CForkStore::NewPage(void)
+{
+	TFORKPAGE *page=mFreePages;
+
+	if(page)
+		mFreePages=page->next_free;
+	else
+		page=new TFORKPAGE;
+
+	page->refs=1;
+	mPagesInUse++;
+	return page;
+}
+
+void CForkStore::Unref(TFORKPAGE *page)
+{
+	if(--page->refs)
+		return;
+
+	page->next_free=mFreePages;
+	mFreePages=page;
+	mPagesInUse--;
+}
+
+TFORK* CForkStore::Save(void)
+{
+	TFORK *fork=(TFORK*)malloc(offsetof(TFORK,rest)+mRestSize);
+
+	if(!fork)
+		return NULL;
+
+	fork->store=this;
+	mRefs++;
+
+	CRam *ram=lynxie->mRam;
+	uint8 *data=ram->GetRamPointer();
+
+	for(int loop=0;loop<RAM_PAGES;loop++)
+	{
+		// Unwritten since the last save or load, still the page it was
+		if(!mLive[loop] || ram->PageDirty(loop,mMark))
+		{
+			TFORKPAGE *page=NewPage();
+			memcpy(page->data,data+loop*RAM_PAGE_SIZE,RAM_PAGE_SIZE);
+			if(mLive[loop])
+				Unref(mLive[loop]);
+			mLive[loop]=page;
+		}
+		fork->pages[loop]=mLive[loop];
+		mLive[loop]->refs++;
+	}
+
+	StateMem st;
+	memset(&st,0,sizeof(st));
+	st.data=fork->rest;
+	st.malloced=mRestSize;
+	st.fixed=1;
+
+	if(!MDFNSS_SaveRawSM(&st,mLayout,data))
+	{
+		Free(fork);
+		return NULL;
+	}
+
+	mMark=ram->DirtyMark();
+	return fork;
+}
+
+bool CForkStore::Load(const TFORK *fork)
+{
+	// Saved in a game since unloaded
+	if(fork->store!=this)
+		return false;
+
+	CRam *ram=lynxie->mRam;
+	uint8 *data=ram->GetRamPointer();
+
+	// RAM first, same as the state sections
+	for(int loop=0;loop<RAM_PAGES;loop++)
+	{
+		TFORKPAGE *page=fork->pages[loop];
+
+		if(page==mLive[loop] && !ram->PageDirty(loop,mMark))
+			continue;
+
+		memcpy(data+loop*RAM_PAGE_SIZE,page->data,RAM_PAGE_SIZE);
+		page->refs++;
+		if(mLive[loop])
+			Unref(mLive[loop]);
+		mLive[loop]=page;
+	}
+
+	StateMem st;
+	memset(&st,0,sizeof(st));
+	st.data=(uint8*)fork->rest;
+	st.len=mRestSize;
+
+	bool ret=MDFNSS_LoadRawSM(&st,mLayout,data);
+
+	mMark=ram->DirtyMark();
+	return ret;
+}
+
+void CForkStore::Free(TFORK *fork)
+{
+	if(!fork)
+		return;
+
+	CForkStore *store=fork->store;
+
+	for(int loop=0;loop<RAM_PAGES;loop++)
+		store->Unref(fork->pages[loop]);
+	free(fork);
+
+	if(!--store->mRefs)
+		delete store;
+}
+
+//END OF FILE
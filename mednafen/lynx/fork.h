@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+// Snapshot forks                                                           //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// A fork is a snapshot of the emulated state whose RAM is held as 256     //
+// byte pages shared with every other fork that has the same contents in   //
+// that page. The store remembers which pages the running RAM was last     //
+// saved to or loaded from and, with the dirty page tracking, only copies  //
+// the pages written since then on a save and only the pages that differ   //
+// on a load. Everything other than RAM is copied whole.                   //
+//                                                                          //
+// Pages are reference counted, and so is the store: the core and every   //
+// fork hold it, so forks outlive the game and are freed through it after  //
+// Release(). Forks and the store must only be used from one thread.       //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef FORK_H
+#define FORK_H
+
+struct TFORKPAGE
+{
+	uint32	refs;
+	union
+	{
+		uint8	data[RAM_PAGE_SIZE];
+		TFORKPAGE	*next_free;
+	};
+};
+
+class CForkStore;
+
+struct TFORK
+{
+	CForkStore	*store;
+	TFORKPAGE	*pages[RAM_PAGES];
+	uint8	rest[1];
+};
+
+class CForkStore
+{
+	// Function members
+
+	public:
+		CForkStore() MDFN_COLD;
+		// Drops the core's reference when the game goes, forks can still be freed
+		void	Release(void) MDFN_COLD;
+
+	private:
+		~CForkStore() MDFN_COLD;
+
+	public:
+		TFORK*	Save(void);
+		bool	Load(const TFORK *fork);
+		static void	Free(TFORK *fork);
+
+		uint32	PagesInUse(void) { return mPagesInUse; };
+
+	private:
+		TFORKPAGE*	NewPage(void);
+		void	Unref(TFORKPAGE *page);
+
+	// Data members
+
+	private:
+		uint32	mRefs;
+		uint64	mLayout;
+		uint32	mRestSize;
+		TFORKPAGE	*mLive[RAM_PAGES];
+		uint32	mMark;
+		TFORKPAGE	*mFreePages;
+		uint32	mPagesInUse;
+};
+
+#endif
@@ -71,6 +71,17 @@ CMikie::CMikie(CSystem& parent)
 	mUART_CABLE_PRESENT=false;
 	mpUART_TX_CALLBACK=NULL;
 
+	mVoiceOutput=false;
+	mSoundEnabled=true;
+	mLazyAudio=false;
+	mLineCount=0;
+	mSyncLines=0;
+
+	for(int slot=0;slot<LFSR_TABLE_SLOTS;slot++) mLfsrTable[slot]=NULL;
+	mLfsrLast=0;
+	mLastLSample=0;
+	mLastRSample=0;
+
 	int loop;
 	for(loop=0;loop<16;loop++) mPalette[loop].Index=loop;
 	for(loop=0;loop<4096;loop++) mColourMap[loop]=0;
@@ -80,6 +91,7 @@ CMikie::CMikie(CSystem& parent)
 
 CMikie::~CMikie()
 {
+	for(int slot=0;slot<LFSR_TABLE_SLOTS;slot++) delete mLfsrTable[slot];
 }
 
 
@@ -263,7 +275,7 @@ void CMikie::Reset(void)
 	mUART_PARITY_EVEN=0;
 }
 
-uint32 CMikie::GetLfsrNext(uint32 current)
+static uint32 LfsrStep(uint32 switches, uint32 lfsr)
 {
 	// The table is built thus:
 	//	Bits 0-11  LFSR					(12 Bits)
@@ -274,22 +286,90 @@ uint32 CMikie::GetLfsrNext(uint32 current)
 	//
 	// Total 21 bits = 2MWords @ 4 Bytes/Word = 8MB !!!!!
 	//
-	// If the index is a combination of Current LFSR+Feedback the
-	// table will give the next value.
+	// Instead of one table for everything CMikie keeps a 4096 entry table
+	// for each feedback setting in use, built from here when the setting
+	// is first seen.
 
-	uint32 switches,lfsr,next,swloop,result;
+	uint32 swloop,result;
 	static const uint32 switchbits[9]={7,0,1,2,3,4,5,10,11};
 
-	switches=current>>12;
-	lfsr=current&0xfff;
 	result=0;
 	for(swloop=0;swloop<9;swloop++)
 	{
 		if((switches>>swloop)&0x001) result^=(lfsr>>switchbits[swloop])&0x001;
 	}
 	result=(result)?0:1;
-	next=(switches<<12)|((lfsr<<1)&0xffe)|result;
-	return next;
+	return ((lfsr<<1)&0xffe)|result;
+}
+
+TLFSRTABLE *CMikie::LfsrTable(uint32 switches)
+{
+	TLFSRTABLE *table=mLfsrTable[mLfsrLast];
+	int slot;
+
+	if(table && table->switches==switches)
+		return table;
+
+	for(slot=0;slot<LFSR_TABLE_SLOTS;slot++)
+	{
+		if(mLfsrTable[slot] && mLfsrTable[slot]->switches==switches)
+		{
+			mLfsrLast=slot;
+			return mLfsrTable[slot];
+		}
+	}
+
+	// New setting, take an empty slot or the one after the last used
+	for(slot=0;slot<LFSR_TABLE_SLOTS && mLfsrTable[slot];slot++);
+	if(slot==LFSR_TABLE_SLOTS)
+		slot=(mLfsrLast+1)%LFSR_TABLE_SLOTS;
+	else
+		mLfsrTable[slot]=new TLFSRTABLE;
+
+	table=mLfsrTable[slot];
+	table->switches=switches;
+	table->levels=1;
+	for(uint32 lfsr=0;lfsr<4096;lfsr++)
+		table->jump[0][lfsr]=LfsrStep(switches,lfsr);
+
+	mLfsrLast=slot;
+	return table;
+}
+
+uint32 CMikie::GetLfsrNext(uint32 current)
+{
+	uint32 switches=current>>12;
+	return (switches<<12)|LfsrTable(switches)->jump[0][current&0xfff];
+}
+
+uint32 CMikie::GetLfsrJump(uint32 current, uint32 steps)
+{
+	uint32 switches=current>>12;
+	uint32 lfsr=current&0xfff;
+	TLFSRTABLE *table=LfsrTable(switches);
+	int level;
+
+	for(level=0;steps && level<LFSR_JUMP_LEVELS;level++,steps>>=1)
+	{
+		if(level==table->levels)
+		{
+			for(uint32 n=0;n<4096;n++)
+				table->jump[level][n]=table->jump[level-1][table->jump[level-1][n]];
+			table->levels++;
+		}
+		if(steps&1)
+			lfsr=table->jump[level][lfsr];
+	}
+
+	// Whatever is left is in units of 2^LFSR_JUMP_LEVELS clocks, two of
+	// the top level each
+	for(;steps;steps--)
+	{
+		lfsr=table->jump[LFSR_JUMP_LEVELS-1][lfsr];
+		lfsr=table->jump[LFSR_JUMP_LEVELS-1][lfsr];
+	}
+
+	return (switches<<12)|lfsr;
 }
 
 void CMikie::PresetForHomebrew(void)
@@ -458,6 +538,8 @@ uint32 CMikie::DisplayRenderLine(void)
 {
 	uint32 work_done=0;
 
+	mLineCount++;
+
 	if(!mpDisplayCurrent) return 0;
 	if(!mDISPCTL_DMAEnable) return 0;
 //	if(mLynxLine&0x80000000) return 0;
@@ -505,6 +587,10 @@ uint32 CMikie::DisplayRenderLine(void)
 		// Assign the temporary pointer;
 		if(!mpSkipFrame)
 		{
+#ifdef WANT_THREADING
+			// Video DMA reads RAM the sprite worker may still be writing
+			mSystem.SpriteSync();
+#endif
 	        CopyLineSurface(mpDisplayCurrent->bpp);
 
 			if(mpDisplayCurrentLine < 102)
@@ -530,6 +616,24 @@ uint32 CMikie::DisplayEndOfFrame(void)
 	return 0;
 }
 
+uint32 CMikie::LineCycles(void)
+{
+	if(!mTIM_0_ENABLE_COUNT)
+		return 0;
+
+	// Timer 0 is always clocked, see Update()
+	return (mTIM_0_BKUP+1)<<(4+mTIM_0_LINKING);
+}
+
+uint32 CMikie::FrameCycles(void)
+{
+	if(!mTIM_2_ENABLE_COUNT)
+		return 0;
+
+	// Timer 2 always counts timer 0 borrows
+	return LineCycles()*(mTIM_2_BKUP+1);
+}
+
 // Peek/Poke memory handlers
 
 void CMikie::Poke(uint32 addr,uint8 data)
@@ -538,6 +642,9 @@ void CMikie::Poke(uint32 addr,uint8 data)
 	if(addr >= 0xFD20 && addr <= 0xFD3F)
 	{
 	 int which = (addr - 0xFD20) >> 3; // Each channel gets 8 ports/registers
+
+	 AudioCatchUp(gSystemCycleCount);
+
 	 switch(addr & 0x7)
 	 {
                 case (AUD0VOL&0x7):
@@ -575,6 +682,10 @@ void CMikie::Poke(uint32 addr,uint8 data)
                                 mAUDIO_LAST_COUNT[which]=gSystemCycleCount;
                                 gNextTimerEvent=gSystemCycleCount;
                         }
+                        // A change of linking can move a channel to or from
+                        // the lazy path, get a prediction for it straight away
+                        if(mLazyAudio)
+                                gNextTimerEvent=gSystemCycleCount;
                         CombobulateSound(gSystemCycleCount - startTS);
                         break;
                 case (AUD0COUNT&0x7):
@@ -816,27 +927,33 @@ void CMikie::Poke(uint32 addr,uint8 data)
 			break;
 
 		case (ATTEN_A&0xff):
+            AudioCatchUp(gSystemCycleCount);
             mAUDIO_ATTEN[0] = data;
             CombobulateSound(gSystemCycleCount - startTS);
             break;
 		case (ATTEN_B&0xff):
+            AudioCatchUp(gSystemCycleCount);
             mAUDIO_ATTEN[1] = data;
             CombobulateSound(gSystemCycleCount - startTS);
             break;
 		case (ATTEN_C&0xff):
+            AudioCatchUp(gSystemCycleCount);
             mAUDIO_ATTEN[2] = data;
             CombobulateSound(gSystemCycleCount - startTS);
             break;
 		case (ATTEN_D&0xff):
+            AudioCatchUp(gSystemCycleCount);
             mAUDIO_ATTEN[3] = data;
             CombobulateSound(gSystemCycleCount - startTS);
             break;
 		case (MPAN&0xff):
+			AudioCatchUp(gSystemCycleCount);
 			mPAN = data;
 			CombobulateSound(gSystemCycleCount - startTS);
 			break;
 
 		case (MSTEREO&0xff):
+			AudioCatchUp(gSystemCycleCount);
 			data^=0xff;
 			mSTEREO=data;
 			CombobulateSound(gSystemCycleCount - startTS);
@@ -930,6 +1047,12 @@ void CMikie::Poke(uint32 addr,uint8 data)
 		case (SDONEACK&0xff):
 			break;
 		case (CPUSLEEP&0xff):
+#ifdef WANT_THREADING
+			// The engine cycle count is added by SpriteSync() when known
+			if(mSystem.PaintSpritesAsync())
+				gSuzieDoneTime = gSystemCycleCount;
+			else
+#endif
 			gSuzieDoneTime = gSystemCycleCount+mSystem.PaintSprites();
 			SetCPUSleep();
 			break;
@@ -1029,6 +1152,8 @@ uint8 CMikie::Peek(uint32 addr)
         if(addr >= 0xFD20 && addr <= 0xFD3F)
         {
          int which = (addr - 0xFD20) >> 3; // Each channel gets 8 ports/registers
+
+         AudioCatchUp(gSystemCycleCount);
          switch(addr & 0x7)
          {
                 case (AUD0VOL&0x7):
@@ -1634,6 +1759,9 @@ int CMikie::StateAction(StateMem *sm, int load, int data_only)
 	SFEND
 	};
 
+	if(!load)
+		AudioCatchUp(gSystemCycleCount);
+
 	int ret = MDFNSS_StateAction(sm, load, data_only, MikieRegs, "MIKY", false);
 
 	if(load)
@@ -1649,10 +1777,13 @@ void CMikie::CombobulateSound(uint32 teatime)
 {
                                 int cur_lsample = 0;
                                 int cur_rsample = 0;
-                                static int last_lsample = 0;
-                                static int last_rsample = 0;
                                 int x;
 
+                                // Channel state is still updated by the callers,
+                                // only the synthesis is skipped
+                                if(!mSoundEnabled)
+                                  return;
+
                                 teatime >>= 2;
                                 for(x = 0; x < 4; x++){
                                    /// Assumption (seems there is no documentation for the Attenuation registers)
@@ -1678,22 +1809,259 @@ void CMikie::CombobulateSound(uint32 teatime)
                                       cur_rsample += mAUDIO_OUTPUT[x];
                                  }
                                 }
-                                if(cur_lsample != last_lsample){
-                                  miksynth.offset_inline(teatime, cur_lsample - last_lsample, mikbuf.left());
-                                  last_lsample = cur_lsample;
+                                if(cur_lsample != mLastLSample){
+                                  miksynth.offset_inline(teatime, cur_lsample - mLastLSample, mikbuf.left());
+                                  mLastLSample = cur_lsample;
+                                }
+                                if(cur_rsample != mLastRSample){
+                                  miksynth.offset_inline(teatime, cur_rsample - mLastRSample, mikbuf.right());
+                                  mLastRSample = cur_rsample;
                                 }
-                                if(cur_rsample != last_rsample){
-                                  miksynth.offset_inline(teatime, cur_rsample - last_rsample, mikbuf.right());
-                                  last_rsample = cur_rsample;
+                                if(mVoiceOutput){
+                                  for(x = 0; x < 4; x++){
+                                    if(mAUDIO_OUTPUT[x] != mVoiceLast[x]){
+                                      miksynth.offset_inline(teatime, mAUDIO_OUTPUT[x] - mVoiceLast[x], &voicebuf[x]);
+                                      mVoiceLast[x] = mAUDIO_OUTPUT[x];
+                                    }
+                                  }
                                 }
 }
 
+//
+// With sound disabled nothing is synthesised and the buffers are not
+// ended or read. Going back to enabled starts the buffers from silence and
+// steps straight to the current channel levels at the start of the frame.
+//
+void CMikie::SetSoundEnabled(bool enable)
+{
+	if(enable && !mSoundEnabled)
+	{
+		mSoundEnabled = true;
+		SoundRestart();
+	}
+	mSoundEnabled = enable;
+}
+
+void CMikie::SoundRestart(void)
+{
+	mikbuf.clear();
+	mLastLSample = 0;
+	mLastRSample = 0;
+
+	for(int x = 0; x < 4; x++)
+	{
+		voicebuf[x].clear();
+		mVoiceLast[x] = 0;
+	}
+
+	CombobulateSound(gSystemCycleCount - startTS);
+}
+
+void CMikie::SetVoiceOutput(bool enable)
+{
+	if(enable && !mVoiceOutput)
+	{
+		// Buffers start silent, the next CombobulateSound() steps up to
+		// the current levels
+		for(int x = 0; x < 4; x++)
+		{
+			voicebuf[x].clear();
+			mVoiceLast[x] = 0;
+		}
+	}
+	mVoiceOutput = enable;
+}
+
+// Samples of the last frame not read by now are dropped, this still has to
+// run them through the reader so the high-pass filter state stays right
+void CMikie::VoiceBeginFrame(void)
+{
+	for(int x = 0; x < 4; x++)
+		ReadVoiceSamples(x, NULL, voicebuf[x].samples_avail());
+}
+
+void CMikie::VoiceEndFrame(uint32 teatime)
+{
+	for(int x = 0; x < 4; x++)
+		voicebuf[x].end_frame(teatime);
+}
+
+long CMikie::ReadVoiceSamples(int voice, int16 *out, long max_samples)
+{
+	Blip_Buffer &buf = voicebuf[voice];
+	long count = buf.samples_avail();
+
+	if(count > max_samples)
+		count = max_samples;
+
+	if(count)
+	{
+		int const bass = BLIP_READER_BASS(buf);
+		BLIP_READER_BEGIN(reader, buf);
+
+		for(long n = 0; n < count; n++)
+		{
+			blip_long s = BLIP_READER_READ(reader);
+			if((int16)s != s)
+				s = 0x7FFF - (s >> 24);
+			if(out)
+				out[n] = (int16)s;
+			BLIP_READER_NEXT(reader, bass);
+		}
+
+		BLIP_READER_END(reader, buf);
+		buf.remove_samples(count);
+	}
+
+	return count;
+}
+
+void CMikie::AudioClock(int y)
+{
+	if(mAUDIO_BKUP[y] || mAUDIO_LINKING[y])
+	 mAUDIO_WAVESHAPER[y] = GetLfsrNext(mAUDIO_WAVESHAPER[y]);
+
+	if(mAUDIO_INTEGRATE_ENABLE[y])
+	{
+		int32 temp=mAUDIO_OUTPUT[y];
+		if(mAUDIO_WAVESHAPER[y]&0x0001) temp+=mAUDIO_VOLUME[y]; else temp-=mAUDIO_VOLUME[y];
+		if(temp>127) temp=127;
+		if(temp<-128) temp=-128;
+		mAUDIO_OUTPUT[y]=(int8)temp;
+	}
+	else
+	{
+		if(mAUDIO_WAVESHAPER[y]&0x0001) mAUDIO_OUTPUT[y]=mAUDIO_VOLUME[y]; else mAUDIO_OUTPUT[y]=-mAUDIO_VOLUME[y];
+	}
+}
+
+//
+// Lazy audio timers. A channel whose borrow out feeds no other timer only
+// shows up in the sound output and in its own registers, so rather than
+// have Update() run every time it borrows its borrows are played back here
+// when something needs them: at every Update(), on a sound register access,
+// at the end of the frame and before a state save. Each borrow happens at
+// its exact cycle instead of at the next Update() after it, borrows of
+// different channels are taken in time order so the mix is right.
+//
+// Far longer than a channel can go without a catch up while it counts
+#define AUDIO_CATCHUP_MAX	(1U << 22)
+
+void CMikie::SetLazyAudio(bool enable)
+{
+	if(mLazyAudio && !enable)
+		AudioCatchUp(gSystemCycleCount);
+
+	mLazyAudio = enable;
+	gNextTimerEvent = gSystemCycleCount;
+}
+
+void CMikie::AudioCatchUp(uint32 until)
+{
+	bool borrowed[4] = { false, false, false, false };
+	int y;
+
+	if(!mLazyAudio)
+		return;
+
+	for(;;)
+	{
+		int next = -1;
+		uint32 next_time = 0;
+
+		for(y = 0; y < 4; y++)
+		{
+			if(!AudioLazy(y) || !mAUDIO_ENABLE_COUNT[y] || !(mAUDIO_ENABLE_RELOAD[y] || !mAUDIO_TIMER_DONE[y]))
+				continue;
+
+			uint32 period = (mAUDIO_CURRENT[y] + 1) << (4 + mAUDIO_LINKING[y]);
+
+			// A stale count (a done timer given reload without a restart)
+			// gets the single collapsed borrow Update() would give it
+			if(until - mAUDIO_LAST_COUNT[y] > AUDIO_CATCHUP_MAX)
+				mAUDIO_LAST_COUNT[y] = until - period;
+
+			uint32 when = mAUDIO_LAST_COUNT[y] + period;
+
+			if((int32)(until - when) >= 0 && (next < 0 || (int32)(when - next_time) < 0))
+			{
+				next = y;
+				next_time = when;
+			}
+		}
+
+		if(next < 0)
+			break;
+
+		y = next;
+		mAUDIO_LAST_COUNT[y] = next_time;
+		mAUDIO_BORROW_OUT[y] = true;
+		mAUDIO_BORROW_IN[y] = true;
+		borrowed[y] = true;
+
+		if(mAUDIO_ENABLE_RELOAD[y])
+			mAUDIO_CURRENT[y] = mAUDIO_BKUP[y];
+		else
+		{
+			mAUDIO_TIMER_DONE[y] = true;
+			mAUDIO_CURRENT[y] = 0;
+		}
+
+		AudioClock(y);
+		CombobulateSound(next_time - startTS);
+
+		// Nobody hears the rest, so jump straight to the last borrow
+		if(mAUDIO_ENABLE_RELOAD[y] && AudioUnheard(y))
+		{
+			uint32 period = (mAUDIO_BKUP[y] + 1) << (4 + mAUDIO_LINKING[y]);
+			uint32 more = (until - next_time) / period;
+
+			if(more)
+			{
+				mAUDIO_LAST_COUNT[y] += more * period;
+
+				if(mAUDIO_BKUP[y] || mAUDIO_LINKING[y])
+					mAUDIO_WAVESHAPER[y] = GetLfsrJump(mAUDIO_WAVESHAPER[y], more);
+
+				if(!mAUDIO_INTEGRATE_ENABLE[y])
+					mAUDIO_OUTPUT[y] = (mAUDIO_WAVESHAPER[y] & 0x0001) ? mAUDIO_VOLUME[y] : -mAUDIO_VOLUME[y];
+			}
+		}
+	}
+
+	// Count down the rest of the way, leaving the flags as Update() would
+	for(y = 0; y < 4; y++)
+	{
+		if(!AudioLazy(y) || !mAUDIO_ENABLE_COUNT[y] || !(mAUDIO_ENABLE_RELOAD[y] || !mAUDIO_TIMER_DONE[y]))
+			continue;
+
+		int32 divide = 4 + mAUDIO_LINKING[y];
+		uint32 decval = (until - mAUDIO_LAST_COUNT[y]) >> divide;
+
+		if(decval)
+		{
+			mAUDIO_LAST_COUNT[y] += decval << divide;
+			mAUDIO_CURRENT[y] -= decval;
+			mAUDIO_BORROW_OUT[y] = false;
+			mAUDIO_BORROW_IN[y] = true;
+		}
+		else if(!borrowed[y])
+		{
+			mAUDIO_BORROW_IN[y] = false;
+			mAUDIO_BORROW_OUT[y] = false;
+		}
+	}
+}
+
 void CMikie::Update(void)
 {
 			int32 divide;
 			int32 decval;
 			uint32 tmp;
 			uint32 mikie_work_done=0;
+#ifdef WANT_THREADING
+			bool suzie_pending=false;
+#endif
 
 			//
 			// To stop problems with cycle count wrap we will check and then correct the
@@ -1728,6 +2096,16 @@ void CMikie::Update(void)
 
 			if(gSuzieDoneTime)
 			{
+#ifdef WANT_THREADING
+				// While the worker is still painting gSuzieDoneTime is only the
+				// start time, its progress is a lower bound on the finish time
+				if(mSystem.SpritesPending() && gSystemCycleCount >= gSuzieDoneTime + mSystem.SpriteProgress())
+					mSystem.SpriteSync();
+
+				if(mSystem.SpritesPending())
+					suzie_pending=true;	// Resolved below against the next timer event
+				else
+#endif
 				if(gSystemCycleCount >= gSuzieDoneTime)
 				{
 					ClearCPUSleep();
@@ -2460,8 +2838,14 @@ void CMikie::Update(void)
 			//
 			{
 			  int y;
+
+			  AudioCatchUp(gSystemCycleCount);
+
 			  for(y = 0; y < 4; y++)
 			  {
+				if(AudioLazy(y))
+					continue;
+
 				if(mAUDIO_ENABLE_COUNT[y] && (mAUDIO_ENABLE_RELOAD[y] || !mAUDIO_TIMER_DONE[y]))
 				{
 					decval=0;
@@ -2511,21 +2895,7 @@ void CMikie::Update(void)
 							//
 							// Update audio circuitry
 							//
-							if(mAUDIO_BKUP[y] || mAUDIO_LINKING[y])
-							 mAUDIO_WAVESHAPER[y] = GetLfsrNext(mAUDIO_WAVESHAPER[y]);
-
-							if(mAUDIO_INTEGRATE_ENABLE[y])
-							{
-								int32 temp=mAUDIO_OUTPUT[y];
-								if(mAUDIO_WAVESHAPER[y]&0x0001) temp+=mAUDIO_VOLUME[y]; else temp-=mAUDIO_VOLUME[y];
-								if(temp>127) temp=127;
-								if(temp<-128) temp=-128;
-								mAUDIO_OUTPUT[y]=(int8)temp;
-							}
-							else
-							{
-								if(mAUDIO_WAVESHAPER[y]&0x0001) mAUDIO_OUTPUT[y]=mAUDIO_VOLUME[y]; else mAUDIO_OUTPUT[y]=-mAUDIO_VOLUME[y];
-							}
+							AudioClock(y);
 							CombobulateSound(gSystemCycleCount - startTS);
 						}
 						else
@@ -2561,6 +2931,18 @@ void CMikie::Update(void)
 
 			//	if(gSystemCycleCount==gNextTimerEvent) gError->Warning("CMikie::Update() - gSystemCycleCount==gNextTimerEvent, system lock likely");
 
+#ifdef WANT_THREADING
+			// The sprite finish time only matters if it comes before the next
+			// timer event, so we need only wait until the worker is past that
+			if(suzie_pending)
+			{
+				if(!mSystem.SpritesPending() || mSystem.SpriteWaitUntil(gNextTimerEvent - gSuzieDoneTime))
+				{
+					if(gSuzieDoneTime < gNextTimerEvent) gNextTimerEvent = gSuzieDoneTime;
+				}
+			}
+#endif
+
 			// Update system IRQ status as a result of timer activity
 			// OR is required to ensure serial IRQ's are not masked accidentally
 		
@@ -155,6 +155,21 @@ enum
 	MIKIE_PIXEL_FORMAT_32BPP,
 };
 
+//
+// Waveshaper jump tables, one per feedback switch setting. jump[k][lfsr]
+// is the LFSR 2^k clocks on, levels above 0 are only built once a jump
+// needs them.
+//
+#define LFSR_JUMP_LEVELS	12
+#define LFSR_TABLE_SLOTS	4
+
+typedef struct
+{
+	uint32	switches;
+	int		levels;
+	uint16	jump[LFSR_JUMP_LEVELS][4096];
+}TLFSRTABLE;
+
 #include <blip/Stereo_Buffer.h>
 
 typedef Blip_Synth<blip_good_quality, 256 * 4> Synth;
@@ -169,6 +184,27 @@ class CMikie : public CLynxBase
 		Synth miksynth;
 		Stereo_Buffer mikbuf;
 
+		// Optional per voice output, the raw channel levels before
+		// stereo/pan/attenuation, each into its own buffer
+		bool mVoiceOutput;
+		Blip_Buffer voicebuf[4];
+
+		bool mSoundEnabled;
+		void	SetSoundEnabled(bool enable);
+		void	SoundRestart(void);
+
+		// Audio timers that nothing links from are stepped lazily, each
+		// borrow at its exact cycle, instead of scheduling timer events.
+		// AudioCatchUp() must run before their state is looked at.
+		bool mLazyAudio;
+		void	SetLazyAudio(bool enable) MDFN_COLD;
+		void	AudioCatchUp(uint32 until);
+
+		void	SetVoiceOutput(bool enable) MDFN_COLD;
+		void	VoiceBeginFrame(void);
+		void	VoiceEndFrame(uint32 teatime);
+		long	ReadVoiceSamples(int voice, int16 *out, long max_samples);
+
 		void	Reset(void) MDFN_COLD;
 
 		uint8	Peek(uint32 addr);
@@ -178,6 +214,7 @@ class CMikie : public CLynxBase
 		uint32	ObjectSize(void) {return MIKIE_SIZE;};
 		void	PresetForHomebrew(void);
 		uint32	GetLfsrNext(uint32 current);
+		uint32	GetLfsrJump(uint32 current, uint32 steps);
 
 		void	ComLynxCable(int status);
 		void	ComLynxRxData(int data);
@@ -191,6 +228,11 @@ class CMikie : public CLynxBase
 		uint32	DisplayRenderLine(void);
 		uint32	DisplayEndOfFrame(void);
 
+		// Cycles per line and per frame as timers 0 and 2 are set, 0 when
+		// they are not counting
+		uint32	LineCycles(void);
+		uint32	FrameCycles(void);
+
 		int StateAction(StateMem *sm, int load, int data_only);
 
 		inline void SetCPUSleep(void) {gSystemCPUSleep=true;};
@@ -199,6 +241,11 @@ class CMikie : public CLynxBase
 		void CombobulateSound(uint32 teatime);
 		void Update(void);
 
+		// Lines started, and how many between sub-frame audio syncs (0 is
+		// once per frame)
+		uint32		mLineCount;
+		uint32		mSyncLines;
+
 		bool		mpSkipFrame;
                 MDFN_Surface*   mpDisplayCurrent;
 		uint32		mpDisplayCurrentLine;
@@ -209,6 +256,27 @@ class CMikie : public CLynxBase
 		// Hardware storage
 		
 		uint32		mDisplayAddress;
+		int			mVoiceLast[4];
+		int			mLastLSample;
+		int			mLastRSample;
+
+		inline bool	AudioLazy(int y) const
+		{
+			return mLazyAudio && mAUDIO_LINKING[y]!=7 && (y==3 || mAUDIO_LINKING[y+1]!=7);
+		}
+		void		AudioClock(int y);
+
+		// More borrows of a reloading channel change nothing that is heard
+		inline bool	AudioUnheard(int y) const
+		{
+			if(mAUDIO_VOLUME[y]==0) return true;
+			if(mAUDIO_INTEGRATE_ENABLE[y]) return false;
+			return !mSoundEnabled || (!(mSTEREO & (0x11 << y)) && !mVoiceOutput);
+		}
+
+		TLFSRTABLE	*mLfsrTable[LFSR_TABLE_SLOTS];
+		int			mLfsrLast;
+		TLFSRTABLE	*LfsrTable(uint32 switches);
 		uint32		mAudioInputComparator;
 		uint32		mTimerStatusFlags;
 		uint32		mTimerInterruptMask;
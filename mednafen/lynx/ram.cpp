@@ -133,6 +133,34 @@ void CRam::Reset(void)
 
 	 gCPUBootAddress = boot_addr;
 	}
+
+	MarkAllDirty();
+}
+
+void CRam::MarkAllDirty(void)
+{
+	for(unsigned i = 0; i < RAM_PAGES; i++)
+	 mPageEpoch[i] = gRamEpoch;
+}
+
+// Fills a bit per page (LSB first) for the pages written since mark,
+// returns how many there are
+uint32 CRam::GetDirtyPages(uint32 mark, uint8 *bitmap)
+{
+	uint32 count = 0;
+
+	memset(bitmap, 0, RAM_PAGES / 8);
+
+	for(unsigned i = 0; i < RAM_PAGES; i++)
+	{
+	 if(PageDirty(i, mark))
+	 {
+	  bitmap[i >> 3] |= 1 << (i & 7);
+	  count++;
+	 }
+	}
+
+	return count;
 }
 
 //END OF FILE
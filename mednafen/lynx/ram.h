@@ -49,6 +49,15 @@
 #define RAM_ADDR_MASK			0xffff
 #define DEFAULT_RAM_CONTENTS	0xff
 
+//
+// Dirty page tracking, every RAM write stamps its page with gRamEpoch.
+// DirtyMark() starts a new epoch and returns the old one, pages written
+// after the call compare newer than the returned mark.
+//
+#define RAM_PAGE_SHIFT			8
+#define RAM_PAGE_SIZE			(1<<RAM_PAGE_SHIFT)
+#define RAM_PAGES				(RAM_SIZE>>RAM_PAGE_SHIFT)
+
 class CRam : public CLynxBase
 {
 
@@ -65,7 +74,7 @@ class CRam : public CLynxBase
 
 		void	Reset(void) MDFN_COLD;
 
-		void	Poke(uint32 addr, uint8 data){ mRamData[(uint16)addr]=data;};
+		void	Poke(uint32 addr, uint8 data){ mRamData[(uint16)addr]=data; MarkDirty(addr);};
 		uint8	Peek(uint32 addr){ return(mRamData[(uint16)addr]);};
 		uint32	ReadCycle(void) {return 5;};
 		uint32	WriteCycle(void) {return 5;};
@@ -73,11 +82,19 @@ class CRam : public CLynxBase
 		uint8*	GetRamPointer(void) { return mRamData; };
 		uint32	CRC32(void) { return mCRC32; };
 
+		uint32*	GetPagePointer(void) { return mPageEpoch; };
+		void	MarkDirty(uint32 addr) { mPageEpoch[(uint16)addr>>RAM_PAGE_SHIFT]=gRamEpoch; };
+		void	MarkAllDirty(void);
+		uint32	DirtyMark(void) { return gRamEpoch++; };
+		bool	PageDirty(uint32 page, uint32 mark) { return (int32)(mPageEpoch[page]-mark)>0; };
+		uint32	GetDirtyPages(uint32 mark, uint8 *bitmap);
+
 		uint32	InfoRAMSize;
 	// Data members
 
 	private:
 		uint8	mRamData[RAM_SIZE];
+		uint32	mPageEpoch[RAM_PAGES];
 		uint8	*mRamXORData;
 		uint16	boot_addr;
 		uint32	mCRC32;
@@ -0,0 +1,337 @@
+//////////////////////////////////////////////////////////////////////////////
+// Rewind buffer                                                            //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// A delta is a list of tokens, each the number of unchanged bytes to skip  //
+// and then a count of changed bytes followed by their XOR, both counts as //
+// LEB128 varints. Trailing unchanged bytes are not coded. Runs of fewer    //
+// than DELTA_MIN_RUN unchanged bytes between changes are cheaper kept in   //
+// the literal than ending it.                                              //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "system.h"
+#include "rewind.h"
+
+#define DELTA_MIN_RUN		4
+#define DELTA_LITERAL_MAX	256
+
+struct TDELTAWRITER
+{
+	uint8	*out;
+	uint32	zeros;
+	uint32	literals;
+	uint8	literal[DELTA_LITERAL_MAX];
+};
+
+static uint8 *PutVarint(uint8 *out, uint32 value)
+{
+	while(value>=0x80)
+	{
+		*out++=(value&0x7f)|0x80;
+		value>>=7;
+	}
+	*out++=value;
+	return out;
+}
+
+static bool GetVarint(const uint8 **in, const uint8 *end, uint32 *value)
+{
+	uint32 result=0;
+
+	for(int shift=0;shift<35;shift+=7)
+	{
+		if(*in>=end)
+			return false;
+
+		uint8 byte=*(*in)++;
+		result|=(uint32)(byte&0x7f)<<shift;
+		if(!(byte&0x80))
+		{
+			*value=result;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void DeltaFlush(TDELTAWRITER *w)
+{
+	if(!w->literals)
+		return;
+
+	w->out=PutVarint(w->out,w->zeros);
+	w->out=PutVarint(w->out,w->literals);
+	memcpy(w->out,w->literal,w->literals);
+	w->out+=w->literals;
+	w->zeros=0;
+	w->literals=0;
+}
+
+static INLINE void DeltaLiteral(TDELTAWRITER *w, uint8 value)
+{
+	w->literal[w->literals++]=value;
+	if(w->literals==DELTA_LITERAL_MAX)
+		DeltaFlush(w);
+}
+
+// A range known to be the same in both states
+static void DeltaSkip(TDELTAWRITER *w, uint32 length)
+{
+	DeltaFlush(w);
+	w->zeros+=length;
+}
+
+static void DeltaScan(TDELTAWRITER *w, const uint8 *a, const uint8 *b, uint32 length)
+{
+	uint32 i=0;
+
+	while(i<length)
+	{
+		if(!w->literals)
+		{
+			uint64 wa,wb;
+
+			while(i+8<=length)
+			{
+				memcpy(&wa,a+i,8);
+				memcpy(&wb,b+i,8);
+				if(wa!=wb)
+					break;
+				i+=8;
+				w->zeros+=8;
+			}
+			while(i<length && a[i]==b[i])
+			{
+				i++;
+				w->zeros++;
+			}
+			if(i==length)
+				break;
+		}
+
+		if(a[i]!=b[i])
+		{
+			DeltaLiteral(w,a[i]^b[i]);
+			i++;
+			continue;
+		}
+
+		uint32 run=i;
+		while(run<length && run-i<DELTA_MIN_RUN && a[run]==b[run])
+			run++;
+
+		if(run-i<DELTA_MIN_RUN && run<length)
+		{
+			while(i<run)
+			{
+				DeltaLiteral(w,0);
+				i++;
+			}
+		}
+		else
+		{
+			DeltaSkip(w,run-i);
+			i=run;
+		}
+	}
+}
+
+static bool DeltaApply(uint8 *state, uint32 size, const uint8 *in, uint32 length)
+{
+	const uint8 *end=in+length;
+	uint32 pos=0;
+
+	while(in<end)
+	{
+		uint32 zeros,literals;
+
+		if(!GetVarint(&in,end,&zeros) || !GetVarint(&in,end,&literals))
+			return false;
+		if(zeros>size-pos || literals>size-pos-zeros || literals>(uint32)(end-in))
+			return false;
+
+		pos+=zeros;
+		for(uint32 n=0;n<literals;n++)
+			state[pos+n]^=in[n];
+		pos+=literals;
+		in+=literals;
+	}
+	return true;
+}
+
+CRewind::CRewind(uint32 budget)
+	:mFirst(0),
+	mCount(0),
+	mBytes(0),
+	mHaveCurrent(false),
+	mMark(0)
+{
+	mLayout=MDFNSS_RawLayout(&mStateSize);
+	mRamOffset=MDFNSS_RawOffset(lynxie->GetRamPointer());
+
+	mRingSize=budget;
+	mRing=new uint8[mRingSize];
+
+	// A delta that does not change a thing is a couple of bytes, the
+	// index does not need to go that far
+	mEntryMax=std::max<uint32>(budget/32,1024);
+	mEntries=new TREWINDENTRY[mEntryMax];
+
+	mCurrent=new uint8[mStateSize];
+	mNext=new uint8[mStateSize];
+	// At worst every byte differs, a token per DELTA_LITERAL_MAX bytes
+	// or one every DELTA_MIN_RUN+1 with short literals, never over 2x
+	mDelta=new uint8[mStateSize*2+64];
+}
+
+CRewind::~CRewind()
+{
+	delete[] mRing;
+	delete[] mEntries;
+	delete[] mCurrent;
+	delete[] mNext;
+	delete[] mDelta;
+}
+
+void CRewind::Clear(void)
+{
+	mFirst=0;
+	mCount=0;
+	mBytes=0;
+	mHaveCurrent=false;
+}
+
+void CRewind::DropOldest(void)
+{
+	mBytes-=mEntries[mFirst].length;
+	mFirst=(mFirst+1)%mEntryMax;
+	mCount--;
+}
+
+bool CRewind::Store(const uint8 *data, uint32 length)
+{
+	if(length>mRingSize)
+	{
+		// The history before this frame can no longer be reached
+		mFirst=0;
+		mCount=0;
+		mBytes=0;
+		return false;
+	}
+
+	uint32 pos=0;
+	uint32 lap_end=~0U;
+
+	if(mCount)
+	{
+		const TREWINDENTRY &newest=mEntries[(mFirst+mCount-1)%mEntryMax];
+		pos=newest.offset+newest.length;
+		if(pos+length>mRingSize)
+		{
+			// Start a new lap, everything past the newest is older than
+			// anything before it and has to go first
+			lap_end=pos;
+			pos=0;
+		}
+	}
+
+	while(mCount)
+	{
+		const TREWINDENTRY &oldest=mEntries[mFirst];
+		bool previous_lap=(oldest.offset>=lap_end);
+		bool overlaps=(oldest.offset<pos+length && oldest.offset+oldest.length>pos);
+
+		if(!previous_lap && !overlaps && mCount<mEntryMax)
+			break;
+		DropOldest();
+	}
+
+	TREWINDENTRY &entry=mEntries[(mFirst+mCount)%mEntryMax];
+	entry.offset=pos;
+	entry.length=length;
+	memcpy(mRing+pos,data,length);
+	mCount++;
+	mBytes+=length;
+	return true;
+}
+
+bool CRewind::Capture(void)
+{
+	StateMem st;
+
+	memset(&st,0,sizeof(st));
+	st.data=mNext;
+	st.malloced=mStateSize;
+	st.fixed=1;
+
+	if(!MDFNSS_SaveRawSM(&st,mLayout))
+		return false;
+
+	CRam *ram=lynxie->mRam;
+	uint32 mark=mMark;
+	mMark=ram->DirtyMark();
+
+	if(mHaveCurrent)
+	{
+		TDELTAWRITER w;
+		w.out=mDelta;
+		w.zeros=0;
+		w.literals=0;
+
+		// Delta to go from the new state back to the kept one
+		DeltaScan(&w,mNext,mCurrent,mRamOffset);
+		for(uint32 page=0;page<RAM_PAGES;page++)
+		{
+			uint32 offset=mRamOffset+page*RAM_PAGE_SIZE;
+
+			if(ram->PageDirty(page,mark))
+				DeltaScan(&w,mNext+offset,mCurrent+offset,RAM_PAGE_SIZE);
+			else
+				DeltaSkip(&w,RAM_PAGE_SIZE);
+		}
+		DeltaScan(&w,mNext+mRamOffset+RAM_SIZE,mCurrent+mRamOffset+RAM_SIZE,mStateSize-mRamOffset-RAM_SIZE);
+		DeltaFlush(&w);
+
+		Store(mDelta,w.out-mDelta);
+	}
+
+	uint8 *swap=mCurrent;
+	mCurrent=mNext;
+	mNext=swap;
+	mHaveCurrent=true;
+	return true;
+}
+
+bool CRewind::StepBack(void)
+{
+	if(!mCount)
+		return false;
+
+	const TREWINDENTRY &newest=mEntries[(mFirst+mCount-1)%mEntryMax];
+
+	if(!DeltaApply(mCurrent,mStateSize,mRing+newest.offset,newest.length))
+	{
+		Clear();
+		return false;
+	}
+	mBytes-=newest.length;
+	mCount--;
+
+	StateMem st;
+	memset(&st,0,sizeof(st));
+	st.data=mCurrent;
+	st.len=mStateSize;
+
+	if(!MDFNSS_LoadRawSM(&st,mLayout))
+	{
+		Clear();
+		return false;
+	}
+
+	// The running state is the kept one again
+	mMark=lynxie->mRam->DirtyMark();
+	return true;
+}
+
+//END OF FILE
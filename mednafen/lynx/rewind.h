@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////////
+// Rewind buffer                                                            //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// Records the emulated state once per frame so that it can be stepped      //
+// back one frame at a time. The newest state is kept whole as a raw        //
+// snapshot, every older one only as the XOR delta to the state after it,   //
+// run length coded so that the unchanged bytes cost next to nothing.       //
+// Stepping back applies the newest delta to the kept state and loads it,   //
+// so costs the same however long the history is. Deltas go in a byte ring  //
+// of a fixed size, the oldest being dropped to make room.                  //
+//                                                                          //
+// RAM pages that the dirty page tracking says have not been written since  //
+// the last capture are known to be unchanged and are not compared.         //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef REWIND_H
+#define REWIND_H
+
+class CRewind
+{
+	// Function members
+
+	public:
+		CRewind(uint32 budget) MDFN_COLD;
+		~CRewind() MDFN_COLD;
+
+	public:
+		bool	Capture(void);
+		bool	StepBack(void);
+		void	Clear(void);
+
+		uint32	Frames(void) { return mCount; };
+		uint32	BytesUsed(void) { return mBytes; };
+
+	private:
+		bool	Store(const uint8 *data, uint32 length);
+		void	DropOldest(void);
+
+	// Data members
+
+	private:
+		struct TREWINDENTRY
+		{
+			uint32	offset;
+			uint32	length;
+		};
+
+		uint8	*mRing;
+		uint32	mRingSize;
+		TREWINDENTRY	*mEntries;
+		uint32	mEntryMax;
+		uint32	mFirst;
+		uint32	mCount;
+		uint32	mBytes;
+
+		uint32	mStateSize;
+		uint64	mLayout;
+		uint32	mRamOffset;
+		uint8	*mCurrent;
+		uint8	*mNext;
+		uint8	*mDelta;
+		bool	mHaveCurrent;
+		uint32	mMark;
+};
+
+#endif
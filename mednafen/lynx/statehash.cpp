@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////
+// State hash                                                               //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "system.h"
+#include "statehash.h"
+
+#define HASH_K1		0x9E3779B185EBCA87ULL
+#define HASH_K2		0xC2B2AE3D27D4EB4FULL
+
+static INLINE uint64 HashRotate(uint64 value, int bits)
+{
+	return (value<<bits)|(value>>(64-bits));
+}
+
+// A word at a time, the tail a byte at a time, then mixed so every input
+// bit reaches every output bit
+static uint64 HashBlock(uint64 hash, const uint8 *data, uint32 length)
+{
+	uint32 i=0;
+
+	for(;i+8<=length;i+=8)
+	{
+		uint64 word;
+		memcpy(&word,data+i,8);
+		hash=HashRotate(hash^(word*HASH_K1),31)*HASH_K2;
+	}
+	for(;i<length;i++)
+		hash=HashRotate(hash^(data[i]*HASH_K1),11)*HASH_K2;
+
+	hash^=length;
+	hash^=hash>>33;
+	hash*=0xFF51AFD7ED558CCDULL;
+	hash^=hash>>33;
+	hash*=0xC4CEB9FE1A85EC53ULL;
+	hash^=hash>>33;
+	return hash;
+}
+
+CStateHash::CStateHash()
+	:mHavePages(false),
+	mMark(0)
+{
+	uint32 size;
+
+	mLayout=MDFNSS_RawLayout(&size);
+	mRestSize=size-RAM_SIZE;
+	mRest=new uint8[mRestSize];
+
+	// Where cart RAM sits in the snapshot without system RAM, which is
+	// saved before it
+	CCart *cart=lynxie->mCart;
+	mCartSize=cart->CartRamSize();
+	mCartOffset=0;
+	if(mCartSize)
+	{
+		mCartOffset=MDFNSS_RawOffset(cart->CartRamPointer());
+		if(mCartOffset==~0U)
+			mCartSize=0;
+		else if(mCartOffset>MDFNSS_RawOffset(lynxie->GetRamPointer()))
+			mCartOffset-=RAM_SIZE;
+	}
+	mCartHash=0;
+	mCartWrites=cart->CartRamWrites();
+}
+
+CStateHash::~CStateHash()
+{
+	delete[] mRest;
+}
+
+uint64 CStateHash::Hash(void)
+{
+	CRam *ram=lynxie->mRam;
+	const uint8 *data=ram->GetRamPointer();
+
+	for(int loop=0;loop<RAM_PAGES;loop++)
+	{
+		if(!mHavePages || ram->PageDirty(loop,mMark))
+			mPageHash[loop]=HashBlock(loop,data+loop*RAM_PAGE_SIZE,RAM_PAGE_SIZE);
+	}
+	CCart *cart=lynxie->mCart;
+
+	if(mCartSize && (!mHavePages || cart->CartRamWrites()!=mCartWrites))
+	{
+		mCartHash=HashBlock(RAM_PAGES,cart->CartRamPointer(),mCartSize);
+		mCartWrites=cart->CartRamWrites();
+	}
+
+	mHavePages=true;
+	mMark=ram->DirtyMark();
+
+	StateMem st;
+	memset(&st,0,sizeof(st));
+	st.data=mRest;
+	st.malloced=mRestSize;
+	st.fixed=1;
+
+	if(!MDFNSS_SaveRawSM(&st,mLayout,data))
+		return 0;
+
+	uint64 hash=HashBlock(mLayout,mRest,mCartOffset);
+	hash=HashBlock(hash,mRest+mCartOffset+mCartSize,mRestSize-mCartOffset-mCartSize);
+	hash=HashBlock(hash,(const uint8*)&mCartHash,sizeof(mCartHash));
+	return HashBlock(hash,(const uint8*)mPageHash,sizeof(mPageHash));
+}
+
+//END OF FILE
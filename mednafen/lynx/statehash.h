@@ -0,0 +1,46 @@
+//////////////////////////////////////////////////////////////////////////////
+// State hash                                                               //
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+// A 64 bit hash of the whole emulated state, cheap enough to take every   //
+// frame. RAM is hashed as 256 byte pages, each kept until the dirty page  //
+// tracking says it was written, and the hash of the page hashes is mixed  //
+// with one of the rest of the state (CPU, Mikie, Susie, cart and system   //
+// registers), which is small and hashed whole every time. Cart RAM is    //
+// hashed again only when the cart has seen a write to it.                 //
+//                                                                          //
+// The result only depends on the state, two instances of the same build   //
+// running the same game agree whenever their states do.                   //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+class CStateHash
+{
+	// Function members
+
+	public:
+		CStateHash() MDFN_COLD;
+		~CStateHash() MDFN_COLD;
+
+	public:
+		uint64	Hash(void);
+
+	// Data members
+
+	private:
+		uint64	mLayout;
+		uint32	mRestSize;
+		uint8	*mRest;
+		uint64	mPageHash[RAM_PAGES];
+		bool	mHavePages;
+		uint32	mMark;
+		uint32	mCartOffset;
+		uint32	mCartSize;
+		uint64	mCartHash;
+		uint32	mCartWrites;
+};
+
+#endif
@@ -50,6 +50,109 @@
 #include "susie.h"
 #include "lynxdef.h"
 
+#ifdef WANT_THREADING
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// Per sprite results a band can not write itself, applied in SCB order
+// once all bands are done
+struct SpriteBandRecord
+{
+	uint16	coldep;
+	uint8	collision;
+	bool	deposit;
+	bool	everon;
+	bool	everonscreen;
+};
+
+// Everything the engine reads or changes in Susie while painting a chain,
+// copied into the bands at the start and back into Susie to undo it
+#define SPRITE_REGS(X) \
+	X(Uuint16,mTMPADR) X(Uuint16,mTILTACUM) X(Uuint16,mHOFF) X(Uuint16,mVOFF) \
+	X(Uuint16,mVIDBAS) X(Uuint16,mCOLLBAS) X(Uuint16,mVIDADR) X(Uuint16,mCOLLADR) \
+	X(Uuint16,mSCBNEXT) X(Uuint16,mSPRDLINE) X(Uuint16,mHPOSSTRT) X(Uuint16,mVPOSSTRT) \
+	X(Uuint16,mSPRHSIZ) X(Uuint16,mSPRVSIZ) X(Uuint16,mSTRETCH) X(Uuint16,mTILT) \
+	X(Uuint16,mSPRDOFF) X(Uuint16,mSPRVPOS) X(Uuint16,mCOLLOFF) X(Uuint16,mVSIZACUM) \
+	X(Uuint16,mHSIZACUM) X(Uuint16,mHSIZOFF) X(Uuint16,mVSIZOFF) X(Uuint16,mSCBADR) \
+	X(Uuint16,mPROCADR) \
+	X(int,mSPRCTL0_Type) X(int,mSPRCTL0_Vflip) X(int,mSPRCTL0_Hflip) X(int,mSPRCTL0_PixelBits) \
+	X(int,mSPRCTL1_StartLeft) X(int,mSPRCTL1_StartUp) X(int,mSPRCTL1_SkipSprite) \
+	X(int,mSPRCTL1_ReloadPalette) X(int,mSPRCTL1_ReloadDepth) X(int,mSPRCTL1_Sizing) \
+	X(int,mSPRCTL1_Literal) X(int,mSPRCOLL_Number) X(int,mSPRCOLL_Collide) \
+	X(int,mSPRSYS_StopOnCurrent) X(int,mSPRSYS_LeftHand) X(int,mSPRSYS_VStretch) \
+	X(int,mSPRSYS_NoCollide) X(int,mSPRSYS_Status) \
+	X(uint32,mSUZYBUSEN) X(TSPRINIT,mSPRINIT) X(uint32,mSPRGO) X(int,mEVERON) \
+	X(int,mCollision) X(int,hquadoff) X(int,vquadoff) X(bool,mCollPlaneEnable)
+
+struct SpriteRegs
+{
+#define SPRITE_REG_FIELD(type,name)	type name;
+	SPRITE_REGS(SPRITE_REG_FIELD)
+#undef SPRITE_REG_FIELD
+	uint8	mPenIndex[16];
+};
+
+struct SpriteBand
+{
+	int		index;
+	int		count;
+	uint32	own_cycles;		// Cycles spent on lines this band owns
+#ifdef WANT_SUZY_STATS
+	uint32	own_bytes;		// Sprite data fetched for lines this band owns
+#endif
+	uint32	line_seq;		// Visible destination lines seen so far
+	uint32	last_own_seq;	// line_seq of the last line this band drew
+	bool	runaway;
+	std::vector<SpriteBandRecord> records;
+	uint8	read_map[0x10000/8];	// RAM read by the engine, SCBs and sprite data
+};
+
+struct SpriteThreads
+{
+	CSusie	*owner;
+
+	// Asynchronous PaintSprites(), job/quit/result are guarded by mutex
+	std::thread				*sprite_thread;
+	std::mutex				mutex;
+	std::condition_variable	cond;
+	bool					job;
+	bool					quit;
+	uint32					result;
+	std::atomic<bool>		done;
+	std::atomic<uint32>		progress;	// Engine cycles used so far
+	bool					progress_safe;	// Chain can not run away, see SpriteChainEnds()
+	std::atomic<uint32>		wait_target;	// Progress SpriteWaitUntil() waits for, 0 if none
+	uint16					chain[SPRITE_CHAIN_MAX+1];
+	uint8					chain_map[0x10000/8];
+
+	// Banded rasteriser, band_gen/band_busy/band_quit guarded by band_mutex
+	int						band_count;
+	std::vector<std::thread>	band_threads;
+	std::mutex				band_mutex;
+	std::condition_variable	band_cond;
+	uint32					band_gen;
+	int						band_busy;
+	bool					band_quit;
+	CSusie					*band_susie[SPRITE_BANDS_MAX];	// 1 on, copies made once
+	SpriteBand				band[SPRITE_BANDS_MAX];
+	SpriteRegs				band_regs;		// Susie before the chain
+	// Screen and collision lines as they were before the chain, saved by
+	// the band that owns the line before it first draws to it
+	bool					line_saved[SCREEN_HEIGHT];
+	uint8					video_save[SCREEN_HEIGHT*(SCREEN_WIDTH/2)];
+	uint8					coll_save[SCREEN_HEIGHT*(SCREEN_WIDTH/2)];
+};
+
+#define CHAIN_MARK(t,a)		((t)->chain_map[(uint16)(a)>>3]|=1<<((a)&7))
+#define CHAIN_CLEAR(t,a)	((t)->chain_map[(uint16)(a)>>3]=0)
+#define CHAIN_TEST(t,a)		((t)->chain_map[(uint16)(a)>>3]&(1<<((a)&7)))
+#define BAND_MARK(b,a)		((b)->read_map[(uint16)(a)>>3]|=1<<((a)&7))
+#define BAND_READ(b,a)		((b)->read_map[(uint16)(a)>>3]&(1<<((a)&7)))
+#endif
+
 //
 // As the Susie sprite engine only ever sees system RAM
 // wa can access this directly without the hassle of
@@ -57,18 +160,57 @@
 //
 #define RAM_PEEK(m)				(mRamPointer[(uint16)(m)])
 #define RAM_PEEKW(m)			(mRamPointer[(uint16)(m)]+(mRamPointer[(uint16)((m)+1)]<<8))
-#define RAM_POKE(m1,m2)			{mRamPointer[(uint16)(m1)]=(m2);}
-
-uint32 cycles_used=0;
+#define RAM_POKE(m1,m2)			{mRamPointer[(uint16)(m1)]=(m2); mRamPages[(uint16)(m1)>>RAM_PAGE_SHIFT]=gRamEpoch;}
 
 CSusie::CSusie(CSystem& parent)
 	:mSystem(parent)
 {
+	mCyclesUsed=0;
+	mHRepeatValid=false;
+	mCollPlaneEnable=false;
+	mCollPlaneOn=false;
+	mCollPlaneValid=false;
+	mCollPlaneDirty=false;
+	memset(mCollLineDirty,0,sizeof(mCollLineDirty));
+	mCollPlaneBase=0;
+#ifdef WANT_SUZY_STATS
+	memset(&mStats,0,sizeof(mStats));
+	memset(&mFrameStats,0,sizeof(mFrameStats));
+#endif
+#ifdef WANT_THREADING
+	mThreads=new SpriteThreads;
+	mThreads->owner=this;
+	mThreads->sprite_thread=NULL;
+	mThreads->job=false;
+	mThreads->quit=false;
+	mThreads->result=0;
+	mThreads->done=true;
+	mThreads->progress=0;
+	mThreads->progress_safe=false;
+	mThreads->wait_target=0;
+	memset(mThreads->chain_map,0,sizeof(mThreads->chain_map));
+	mThreads->band_count=1;
+	mThreads->band_gen=0;
+	mThreads->band_busy=0;
+	mThreads->band_quit=false;
+	for(int i=0;i<SPRITE_BANDS_MAX;i++) mThreads->band_susie[i]=NULL;
+	mBand=NULL;
+	mSpritePending=false;
+#endif
 	Reset();
 }
 
 CSusie::~CSusie()
 {
+#ifdef WANT_THREADING
+	// Band copies share the owner's threads
+	if(mThreads->owner!=this)
+		return;
+
+	SetSpriteThread(false);
+	SetSpriteBands(1);
+	delete mThreads;
+#endif
 }
 
 void CSusie::Reset(void)
@@ -77,6 +219,7 @@ void CSusie::Reset(void)
 	// and seeing as Susie only ever sees RAM.
 
 	mRamPointer=mSystem.GetRamPointer();
+	mRamPages=mSystem.GetRamPagePointer();
 
 	// Reset ALL variables
 
@@ -234,6 +377,21 @@ void CSusie::DoMathDivide(void)
 
 
 uint32 CSusie::PaintSprites(void)
+{
+	uint32 cycles;
+
+#ifdef WANT_THREADING
+	if(mThreads->band_count>1 && mSUZYBUSEN && mSPRGO)
+		cycles=PaintSpritesBanded();
+	else
+#endif
+		cycles=PaintSpriteChain();
+
+	SUZY_STAT(mStats.cycles+=cycles);
+	return cycles;
+}
+
+uint32 CSusie::PaintSpriteChain(void)
 {
 	int	sprcount=0;
 	int data=0;
@@ -242,7 +400,11 @@ uint32 CSusie::PaintSprites(void)
 	if(!mSUZYBUSEN || !mSPRGO)
 		return 0;
 
-	cycles_used=0;
+	mCyclesUsed=0;
+
+	mCollPlaneOn=false;
+	if(mCollPlaneEnable)
+		CollisionPlaneSync();
 
 	do
 	{
@@ -263,9 +425,14 @@ uint32 CSusie::PaintSprites(void)
 			mSPRSYS_Status=1;
 		}
 
+		SUZY_STAT(mStats.scbs++);
+
 		mTMPADR.Val16=mSCBNEXT.Val16;	// Copy SCB pointer
 		mSCBADR.Val16=mSCBNEXT.Val16;	// Copy SCB pointer
 
+		if(mCollPlaneDirty)
+			CollisionPlaneRead(mSCBADR.Val16,SCB_SIZE_MAX);
+
 		data=RAM_PEEK(mTMPADR.Val16);			// Fetch control 0
 		mSPRCTL0_Type=data&0x0007;
 		mSPRCTL0_Vflip=data&0x0010;
@@ -291,7 +458,15 @@ uint32 CSusie::PaintSprites(void)
 		mSCBNEXT.Val16=RAM_PEEKW(mTMPADR.Val16);	// Next SCB
 		mTMPADR.Val16+=2;
 
-		cycles_used+=5*SPR_RDWR_CYC;
+		mCyclesUsed+=5*SPR_RDWR_CYC;
+
+#ifdef WANT_THREADING
+		if(mBand)
+		{
+			for(uint16 addr=mSCBADR.Val16;addr!=mTMPADR.Val16;addr++)
+				BAND_MARK(mBand,addr);
+		}
+#endif
 
 		// Initialise the collision depositary
 
@@ -305,8 +480,11 @@ uint32 CSusie::PaintSprites(void)
 
 		// Check if this is a skip sprite
 
+		SUZY_STAT(mStats.skipped+=mSPRCTL1_SkipSprite?1:0);
+
 		if(!mSPRCTL1_SkipSprite)
 		{
+			SUZY_STAT(mStats.drawn[mSPRCTL0_Type]++);
 
 			mSPRDLINE.Val16=RAM_PEEKW(mTMPADR.Val16);	// Sprite pack data
 			mTMPADR.Val16+=2;
@@ -317,7 +495,7 @@ uint32 CSusie::PaintSprites(void)
 			mVPOSSTRT.Val16=RAM_PEEKW(mTMPADR.Val16);	// Sprite vertical start position
 			mTMPADR.Val16+=2;
 
-			cycles_used+=6*SPR_RDWR_CYC;
+			mCyclesUsed+=6*SPR_RDWR_CYC;
 
 			bool enable_sizing=false;
 			bool enable_stretch=false;
@@ -336,7 +514,7 @@ uint32 CSusie::PaintSprites(void)
 					mSPRVSIZ.Val16=RAM_PEEKW(mTMPADR.Val16);	// Sprite Verticalal size
 					mTMPADR.Val16+=2;
 
-					cycles_used+=4*SPR_RDWR_CYC;
+					mCyclesUsed+=4*SPR_RDWR_CYC;
 					break;
 
 				case 2:
@@ -352,7 +530,7 @@ uint32 CSusie::PaintSprites(void)
 					mSTRETCH.Val16=RAM_PEEKW(mTMPADR.Val16);	// Sprite stretch
 					mTMPADR.Val16+=2;
 
-					cycles_used+=6*SPR_RDWR_CYC;
+					mCyclesUsed+=6*SPR_RDWR_CYC;
 					break;
 
 				case 3:
@@ -372,7 +550,7 @@ uint32 CSusie::PaintSprites(void)
 					mTILT.Val16=RAM_PEEKW(mTMPADR.Val16);		// Sprite tilt
 					mTMPADR.Val16+=2;
 
-					cycles_used+=8*SPR_RDWR_CYC;
+					mCyclesUsed+=8*SPR_RDWR_CYC;
 					break;
 
 				default:
@@ -390,8 +568,20 @@ uint32 CSusie::PaintSprites(void)
 					mPenIndex[(loop*2)+1]=data_tmp&0x0f;
 				}
 				// Increment cycle count for the reads
-				cycles_used+=8*SPR_RDWR_CYC;
+				mCyclesUsed+=8*SPR_RDWR_CYC;
+			}
+
+#ifdef WANT_THREADING
+			if(mBand)
+			{
+				for(uint16 addr=mSCBADR.Val16+5;addr!=mTMPADR.Val16;addr++)
+					BAND_MARK(mBand,addr);
 			}
+#endif
+
+			// Lines can be drawn from the cached horizontal repeat pattern
+			// unless stretch changes SPRHSIZ (or tilt the start) every line
+			bool spans=!(enable_stretch && mSTRETCH.Val16) && !(enable_tilt && mTILT.Val16);
 
 			// Now we can start painting
 		
@@ -590,33 +780,70 @@ uint32 CSusie::PaintSprites(void)
 								if(loop==0)	hquadoff=hsign;
 								if(hsign!=hquadoff) hoff+=hsign;
 
-								// Initialise our line
-								LineInit(voff);
-								onscreen=false;
-
-								// Now render an individual destination line
-								while((pixel=LineGetPixel())!=LINE_END)
+#ifdef WANT_THREADING
+								// Lines owned by another band only advance the sequence
+								if(mBand && ((voff>>3)%mBand->count)!=mBand->index)
 								{
-									// This is allowed to update every pixel
-									mHSIZACUM.Val16+=mSPRHSIZ.Val16;
-									pixel_width=mHSIZACUM.Union8.High;
-									mHSIZACUM.Union8.High=0;
-
-									for(hloop=0;hloop<pixel_width;hloop++)
+									mBand->line_seq++;
+								}
+								else
+#endif
+								{
+#ifdef WANT_THREADING
+									uint32 line_start=mCyclesUsed;
+#ifdef WANT_SUZY_STATS
+									uint32 line_bytes=mStats.bytes;
+#endif
+#endif
+#ifdef WANT_THREADING
+									if(mBand)
+										BandSaveLine(voff);
+#endif
+									// Initialise our line
+									LineInit(voff);
+									onscreen=false;
+
+									if(spans)
 									{
-										// Draw if onscreen but break loop on transition to offscreen
-										if(hoff>=0 && hoff<SCREEN_WIDTH)
-										{
-											ProcessPixel(hoff,pixel);
-											onscreen = true;
-											everonscreen = true;
-										}
-										else
+										if(LineRenderSpans(hoff,hsign)) everonscreen = true;
+									}
+									else
+									{
+										// Now render an individual destination line
+										while((pixel=LineGetPixel())!=LINE_END)
 										{
-											if(onscreen) break;
+											// This is allowed to update every pixel
+											mHSIZACUM.Val16+=mSPRHSIZ.Val16;
+											pixel_width=mHSIZACUM.Union8.High;
+											mHSIZACUM.Union8.High=0;
+
+											for(hloop=0;hloop<pixel_width;hloop++)
+											{
+												// Draw if onscreen but break loop on transition to offscreen
+												if(hoff>=0 && hoff<SCREEN_WIDTH)
+												{
+													ProcessPixel(hoff,pixel);
+													onscreen = true;
+													everonscreen = true;
+												}
+												else
+												{
+													if(onscreen) break;
+												}
+												hoff+=hsign;
+											}
 										}
-										hoff+=hsign;
 									}
+#ifdef WANT_THREADING
+									if(mBand)
+									{
+										mBand->own_cycles+=mCyclesUsed-line_start;
+#ifdef WANT_SUZY_STATS
+										mBand->own_bytes+=mStats.bytes-line_bytes;
+#endif
+										mBand->last_own_seq=++mBand->line_seq;
+									}
+#endif
 								}
 							}
 							voff+=vsign;
@@ -672,6 +899,9 @@ uint32 CSusie::PaintSprites(void)
 
 			// Write the collision depositary if required
 
+			bool deposit=false;
+			uint16 coldep=mSCBADR.Val16+mCOLLOFF.Val16;
+
 			if(!mSPRCOLL_Collide && !mSPRSYS_NoCollide)
 			{
 				switch(mSPRCTL0_Type)
@@ -681,28 +911,68 @@ uint32 CSusie::PaintSprites(void)
 					case sprite_normal:
 					case sprite_boundary_shadow:
 					case sprite_shadow:
-						{
-							uint16 coldep=mSCBADR.Val16+mCOLLOFF.Val16;
-							RAM_POKE(coldep,(uint8)mCollision);
-						}
+						deposit=true;
 						break;
 					default:
 						break;
 				}
 			}
 
-			if(mEVERON)
+#ifdef WANT_THREADING
+			if(mBand)
 			{
-				uint16 coldep=mSCBADR.Val16+mCOLLOFF.Val16;
-				uint8 coldat=RAM_PEEK(coldep);
-				if(!everonscreen) coldat|=0x80; else coldat&=0x7f;
-				RAM_POKE(coldep,coldat);
+				// Only part of the sprite was seen, the merge does the writes
+				SpriteBandRecord rec;
+				rec.coldep=coldep;
+				rec.collision=(uint8)mCollision;
+				rec.deposit=deposit;
+				rec.everon=mEVERON;
+				rec.everonscreen=everonscreen;
+				mBand->records.push_back(rec);
+			}
+			else
+#endif
+			{
+				if(mCollPlaneDirty && (deposit || mEVERON))
+					CollisionPlaneRead(coldep,1);
+
+				if(deposit)
+					RAM_POKE(coldep,(uint8)mCollision);
+
+				if(mEVERON)
+				{
+					uint8 coldat=RAM_PEEK(coldep);
+					if(!everonscreen) coldat|=0x80; else coldat&=0x7f;
+					RAM_POKE(coldep,coldat);
+				}
+
+				// A depositary may sit inside the collision buffer
+				if(mCollPlaneOn && (deposit || mEVERON))
+					CollisionPlaneTouch(coldep);
 			}
 		}
 
 		// Increase sprite number
 		sprcount++;
 
+#ifdef WANT_THREADING
+		// Lets the CPU thread run timers up to this point while we carry on,
+		// with bands only the owner's (partial) count is a safe lower bound
+		if(mThreads->owner==this && mThreads->progress_safe)
+		{
+			SpriteThreads *t=mThreads;
+			uint32 target;
+
+			t->progress.store(mCyclesUsed);
+			target=t->wait_target.load();
+			if(target && mCyclesUsed>=target)
+			{
+				std::lock_guard<std::mutex> lock(t->mutex);
+				t->cond.notify_all();
+			}
+		}
+#endif
+
 		// Check if we abort after 1st sprite is complete
 
 //		if(mSPRSYS.Read.StopOnCurrent) 
@@ -713,8 +983,17 @@ uint32 CSusie::PaintSprites(void)
 //		}
 
 		// Check sprcount for looping SCB, random large number chosen
-		if(sprcount>4096)
+		if(sprcount>SPRITE_CHAIN_MAX)
 		{
+			if(mCollPlaneDirty)
+				CollisionPlaneWriteBack();
+#ifdef WANT_THREADING
+			if(mBand)
+			{
+				mBand->runaway=true;
+				return 0;
+			}
+#endif
 			// Stop the system, otherwise we may just come straight back in.....
 			gSystemHalt=true;
 			// Display warning message
@@ -725,12 +1004,473 @@ uint32 CSusie::PaintSprites(void)
 	}
 	while(1);
 
+	if(mCollPlaneDirty)
+		CollisionPlaneWriteBack();
+
 	// Fudge factor to fix many flickering issues, also the keypress
 	// problem with Hard Drivin and the strange pause in Dirty Larry.
-	//cycles_used>>=2;
-	return cycles_used;
+	//mCyclesUsed>>=2;
+	return mCyclesUsed;
+}
+
+#ifdef WANT_THREADING
+//
+// The worker thread owns Susie and the RAM from PaintSpritesAsync() until
+// SpriteSync(), the CPU thread must call SpriteSync() before it touches
+// either of them. Timer updates that only need to know the engine has not
+// yet finished can use SpriteProgress() as a lower bound on the final
+// cycle count. A chain that runs away (more than SPRITE_CHAIN_MAX SCBs)
+// is aborted with a count of 0, so progress is only published for chains
+// known up front to end in time, anything else stays at 0 until the end.
+//
+void CSusie::SetSpriteThread(bool enable)
+{
+	SpriteThreads *t=mThreads;
+
+	if(enable && !t->sprite_thread)
+	{
+		t->quit=false;
+		t->sprite_thread=new std::thread(&CSusie::SpriteWorker,this);
+	}
+	else if(!enable && t->sprite_thread)
+	{
+		SpriteSync();
+		{
+			std::lock_guard<std::mutex> lock(t->mutex);
+			t->quit=true;
+		}
+		t->cond.notify_all();
+		t->sprite_thread->join();
+		delete t->sprite_thread;
+		t->sprite_thread=NULL;
+	}
+}
+
+void CSusie::SpriteWorker(void)
+{
+	SpriteThreads *t=mThreads;
+	std::unique_lock<std::mutex> lock(t->mutex);
+
+	for(;;)
+	{
+		while(!t->job && !t->quit) t->cond.wait(lock);
+		if(t->quit) break;
+
+		lock.unlock();
+		uint32 result=PaintSprites();
+		lock.lock();
+
+		t->result=result;
+		t->job=false;
+		t->done.store(true,std::memory_order_release);
+		t->cond.notify_all();
+	}
+}
+
+// Follows the SCBNEXT links the way PaintSpriteChain() will. The walk
+// only holds if painting can not change a link, none may sit in the
+// screen or collision buffer or be a collision depositary.
+bool CSusie::SpriteChainEnds(void)
+{
+	SpriteThreads *t=mThreads;
+	const uint32 region=SCREEN_HEIGHT*(SCREEN_WIDTH/2);
+	uint16 scb=mSCBNEXT.Val16;
+	int count=0;
+	bool ends=true;
+
+	while(scb&0xff00)
+	{
+		if(count==SPRITE_CHAIN_MAX)
+		{
+			ends=false;
+			break;
+		}
+		t->chain[count++]=scb;
+		CHAIN_MARK(t,scb+mCOLLOFF.Val16);
+		scb=RAM_PEEKW(scb+3);
+	}
+
+	for(int n=0;n<count && ends;n++)
+	{
+		for(uint16 link=t->chain[n]+3;link!=(uint16)(t->chain[n]+5);link++)
+		{
+			if(CHAIN_TEST(t,link) || (uint16)(link-mVIDBAS.Val16)<region || (uint16)(link-mCOLLBAS.Val16)<region)
+				ends=false;
+		}
+	}
+
+	for(int n=0;n<count;n++)
+		CHAIN_CLEAR(t,t->chain[n]+mCOLLOFF.Val16);
+
+	return ends;
+}
+
+bool CSusie::PaintSpritesAsync(void)
+{
+	SpriteThreads *t=mThreads;
+
+	// Nothing to paint is handled inline, PaintSprites() returns at once
+	if(!t->sprite_thread || !mSUZYBUSEN || !mSPRGO)
+		return false;
+
+	t->progress_safe=SpriteChainEnds();
+	t->progress.store(0,std::memory_order_relaxed);
+	t->done.store(false,std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(t->mutex);
+		t->job=true;
+	}
+	t->cond.notify_all();
+	mSpritePending=true;
+	return true;
+}
+
+void CSusie::SpriteSync(void)
+{
+	SpriteThreads *t=mThreads;
+
+	if(!mSpritePending)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(t->mutex);
+		while(t->job) t->cond.wait(lock);
+	}
+	mSpritePending=false;
+
+	// gSuzieDoneTime held the start time (plus any ADDCYC since), the
+	// addition is the same one Mikie would have done synchronously
+	gSuzieDoneTime+=t->result;
+}
+
+uint32 CSusie::SpriteProgress(void)
+{
+	return mThreads->progress.load(std::memory_order_acquire);
+}
+
+// Wait until the engine has used at least "cycles" or finished, returns
+// true if it finished (and has been synced)
+bool CSusie::SpriteWaitUntil(uint32 cycles)
+{
+	SpriteThreads *t=mThreads;
+	bool reached=false;
+
+	{
+		std::unique_lock<std::mutex> lock(t->mutex);
+
+		// The worker looks at the target after publishing progress, so one
+		// of the two sees the other
+		t->wait_target.store(cycles?cycles:1);
+		while(t->job)
+		{
+			if(t->progress.load()>=cycles)
+			{
+				reached=true;
+				break;
+			}
+			t->cond.wait(lock);
+		}
+		t->wait_target.store(0);
+	}
+
+	if(reached)
+		return false;
+
+	SpriteSync();
+	return true;
 }
 
+//
+// Banded rasteriser. Band n renders the destination lines with
+// ((voff>>3)%count)==n, everything else (SCB fetch, source line decode,
+// tilt/stretch/size accumulators) is done by every band so that they all
+// stay in step. Band 0 runs on the calling thread on Susie itself, the
+// others on copies. Writes that are not to the band's own lines, the
+// collision depositary and EVERON bits, are recorded per sprite and
+// applied afterwards in SCB order using the maximum collision number and
+// the OR of the on screen flags.
+//
+// This is only equivalent to the serial engine if nothing the engine reads,
+// SCBs and sprite data, is written during the chain, each band keeps a map
+// of those reads which is checked once all are done. On a conflict the
+// screen/collision lines drawn and the Susie registers are put back and
+// the chain is run serially.
+//
+// The band copies are made when the band count is set and only get the
+// registers (SpriteRegs) at the start of each chain, their collision
+// planes catch up with RAM in CollisionPlaneSync() like Susie's own.
+//
+void CSusie::SaveSpriteRegs(SpriteRegs *regs)
+{
+#define SPRITE_REG_SAVE(type,name)	regs->name=name;
+	SPRITE_REGS(SPRITE_REG_SAVE)
+#undef SPRITE_REG_SAVE
+	memcpy(regs->mPenIndex,mPenIndex,sizeof(mPenIndex));
+}
+
+void CSusie::LoadSpriteRegs(const SpriteRegs *regs)
+{
+#define SPRITE_REG_LOAD(type,name)	name=regs->name;
+	SPRITE_REGS(SPRITE_REG_LOAD)
+#undef SPRITE_REG_LOAD
+	memcpy(mPenIndex,regs->mPenIndex,sizeof(mPenIndex));
+}
+
+// Lines of different bands never overlap, so neither do their saves
+INLINE void CSusie::BandSaveLine(int voff)
+{
+	SpriteThreads *t=mThreads;
+
+	if(t->line_saved[voff])
+		return;
+
+	const uint32 start=voff*(SCREEN_WIDTH/2);
+	for(uint32 i=start;i<start+SCREEN_WIDTH/2;i++)
+	{
+		t->video_save[i]=RAM_PEEK(mVIDBAS.Val16+i);
+		t->coll_save[i]=RAM_PEEK(mCOLLBAS.Val16+i);
+	}
+	t->line_saved[voff]=true;
+}
+
+void CSusie::SetSpriteBands(int count)
+{
+	SpriteThreads *t=mThreads;
+
+	if(count<1) count=1;
+	if(count>SPRITE_BANDS_MAX) count=SPRITE_BANDS_MAX;
+
+	if(count==t->band_count)
+		return;
+
+	SpriteSync();
+
+	if(!t->band_threads.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(t->band_mutex);
+			t->band_quit=true;
+		}
+		t->band_cond.notify_all();
+		for(size_t i=0;i<t->band_threads.size();i++)
+			t->band_threads[i].join();
+		t->band_threads.clear();
+		t->band_quit=false;
+	}
+
+	for(int i=1;i<SPRITE_BANDS_MAX;i++)
+	{
+		delete t->band_susie[i];
+		t->band_susie[i]=NULL;
+	}
+
+	t->band_count=count;
+
+	for(int i=1;i<count;i++)
+	{
+		t->band_susie[i]=new CSusie(*this);
+		t->band_threads.push_back(std::thread(&CSusie::SpriteBandWorker,this,i,t->band_gen));
+	}
+}
+
+void CSusie::SpriteBandWorker(int index,uint32 generation)
+{
+	SpriteThreads *t=mThreads;
+	std::unique_lock<std::mutex> lock(t->band_mutex);
+
+	for(;;)
+	{
+		while(t->band_gen==generation && !t->band_quit) t->band_cond.wait(lock);
+		if(t->band_quit) break;
+		generation=t->band_gen;
+
+		CSusie *band=t->band_susie[index];
+		lock.unlock();
+		band->PaintSpriteChain();
+		lock.lock();
+
+		t->band_busy--;
+		t->band_cond.notify_all();
+	}
+}
+
+uint32 CSusie::PaintSpritesBanded(void)
+{
+	SpriteThreads *t=mThreads;
+	const int count=t->band_count;
+	const uint16 vidbas=mVIDBAS.Val16;
+	const uint16 collbas=mCOLLBAS.Val16;
+	const uint32 region=SCREEN_HEIGHT*(SCREEN_WIDTH/2);
+
+	// Screen and collision lines of different bands are only disjoint if
+	// the two buffers are either the same or do not overlap at all
+	if(vidbas!=collbas && ((uint16)(collbas-vidbas)<region || (uint16)(vidbas-collbas)<region))
+		return PaintSpriteChain();
+
+#ifdef WANT_SUZY_STATS
+	TSUZYSTATS stats_save=mStats;
+#endif
+
+	SaveSpriteRegs(&t->band_regs);
+	memset(t->line_saved,0,sizeof(t->line_saved));
+
+	for(int i=0;i<count;i++)
+	{
+		SpriteBand *b=&t->band[i];
+		b->index=i;
+		b->count=count;
+		b->own_cycles=0;
+#ifdef WANT_SUZY_STATS
+		b->own_bytes=0;
+#endif
+		b->line_seq=0;
+		b->last_own_seq=0;
+		b->runaway=false;
+		b->records.clear();
+		memset(b->read_map,0,sizeof(b->read_map));
+	}
+
+	t->band_susie[0]=this;
+	for(int i=1;i<count;i++)
+	{
+		CSusie *band=t->band_susie[i];
+		band->LoadSpriteRegs(&t->band_regs);
+		band->mBand=&t->band[i];
+#ifdef WANT_SUZY_STATS
+		memset(&band->mStats,0,sizeof(TSUZYSTATS));
+#endif
+	}
+	mBand=&t->band[0];
+
+	{
+		std::lock_guard<std::mutex> lock(t->band_mutex);
+		t->band_busy=count-1;
+		t->band_gen++;
+	}
+	t->band_cond.notify_all();
+
+	PaintSpriteChain();
+
+	{
+		std::unique_lock<std::mutex> lock(t->band_mutex);
+		while(t->band_busy) t->band_cond.wait(lock);
+	}
+	mBand=NULL;
+
+	// Check nothing read outside the own lines was written by anyone
+	SpriteBand *first=&t->band[0];
+	bool ok=true;
+
+	for(int i=1;i<count && ok;i++)
+	{
+		SpriteBand *b=&t->band[i];
+		if(b->records.size()!=first->records.size() || b->line_seq!=first->line_seq || b->runaway!=first->runaway)
+			ok=false;
+		for(uint32 n=0;n<sizeof(first->read_map);n++)
+			first->read_map[n]|=b->read_map[n];
+	}
+
+	for(uint32 i=0;i<region && ok;i++)
+	{
+		if(BAND_READ(first,(uint16)(vidbas+i)) || BAND_READ(first,(uint16)(collbas+i)))
+			ok=false;
+	}
+
+	for(size_t n=0;n<first->records.size() && ok;n++)
+	{
+		const SpriteBandRecord &rec=first->records[n];
+		if(!rec.deposit && !rec.everon)
+			continue;
+		if(BAND_READ(first,rec.coldep) || (uint16)(rec.coldep-vidbas)<region || (uint16)(rec.coldep-collbas)<region)
+			ok=false;
+	}
+
+	uint32 cycles=mCyclesUsed-first->own_cycles;
+	int last=0;
+
+	if(ok)
+	{
+		for(int i=0;i<count;i++)
+		{
+			CSusie *band=t->band_susie[i];
+			cycles+=t->band[i].own_cycles;
+			if(band->mCollision>mCollision)
+				mCollision=band->mCollision;
+			if(t->band[i].last_own_seq>t->band[last].last_own_seq)
+				last=i;
+#ifdef WANT_SUZY_STATS
+			// Everything else the copies counted was also counted here
+			if(i)
+			{
+				mStats.pixels+=band->mStats.pixels;
+				mStats.coll_reads+=band->mStats.coll_reads;
+				mStats.coll_writes+=band->mStats.coll_writes;
+				mStats.bytes+=t->band[i].own_bytes;
+			}
+#endif
+		}
+
+		// The horizontal accumulator is left over from the last line drawn
+		mHSIZACUM=t->band_susie[last]->mHSIZACUM;
+
+		for(size_t n=0;n<first->records.size();n++)
+		{
+			const SpriteBandRecord &rec=first->records[n];
+			uint8 collision=rec.collision;
+			bool everonscreen=rec.everonscreen;
+
+			for(int i=1;i<count;i++)
+			{
+				const SpriteBandRecord &other=t->band[i].records[n];
+				if(other.collision>collision)
+					collision=other.collision;
+				everonscreen|=other.everonscreen;
+			}
+
+			if(rec.deposit)
+				RAM_POKE(rec.coldep,collision);
+
+			if(rec.everon)
+			{
+				uint8 coldat=RAM_PEEK(rec.coldep);
+				if(!everonscreen) coldat|=0x80; else coldat&=0x7f;
+				RAM_POKE(rec.coldep,coldat);
+			}
+		}
+	}
+
+	if(!ok)
+	{
+		for(int line=0;line<SCREEN_HEIGHT;line++)
+		{
+			if(!t->line_saved[line])
+				continue;
+			for(uint32 i=line*(SCREEN_WIDTH/2);i<(line+1)*(SCREEN_WIDTH/2);i++)
+			{
+				RAM_POKE(vidbas+i,t->video_save[i]);
+				RAM_POKE(collbas+i,t->coll_save[i]);
+			}
+		}
+		LoadSpriteRegs(&t->band_regs);
+#ifdef WANT_SUZY_STATS
+		mStats=stats_save;
+#endif
+
+		return PaintSpriteChain();
+	}
+
+	if(first->runaway)
+	{
+		// Same as the serial engine, stop the system and report nothing
+		gSystemHalt=true;
+		return 0;
+	}
+
+	mCyclesUsed=cycles;
+	return cycles;
+}
+#endif
+
 
 INLINE void CSusie::WritePixel(uint32 hoff,uint32 pixel)
 {
@@ -751,8 +1491,10 @@ INLINE void CSusie::WritePixel(uint32 hoff,uint32 pixel)
         }
         RAM_POKE(scr_addr,dest);
 
+        SUZY_STAT(mStats.pixels++);
+
         // Increment cycle count for the read/modify/write
-        cycles_used+=2*SPR_RDWR_CYC;
+        mCyclesUsed+=2*SPR_RDWR_CYC;
 }
 
 INLINE uint32 CSusie::ReadPixel(uint32 hoff)
@@ -772,13 +1514,24 @@ INLINE uint32 CSusie::ReadPixel(uint32 hoff)
         }
 
         // Increment cycle count for the read/modify/write
-        cycles_used+=SPR_RDWR_CYC;
+        mCyclesUsed+=SPR_RDWR_CYC;
 
         return data;
 }
 
 INLINE void CSusie::WriteCollision(uint32 hoff,uint32 pixel)
 {
+        if(mCollPlaneOn)
+        {
+                mLineCollisionPlane[hoff]=pixel;
+                *mLineCollisionDirty=true;
+                mCollPlaneDirty=true;
+
+                SUZY_STAT(mStats.coll_writes++);
+                mCyclesUsed+=2*SPR_RDWR_CYC;
+                return;
+        }
+
         const uint16 col_addr=mLineCollisionAddress+(hoff/2);
 
         uint8 dest=RAM_PEEK(col_addr);
@@ -796,12 +1549,21 @@ INLINE void CSusie::WriteCollision(uint32 hoff,uint32 pixel)
         }
         RAM_POKE(col_addr,dest);
 
+        SUZY_STAT(mStats.coll_writes++);
+
         // Increment cycle count for the read/modify/write
-        cycles_used+=2*SPR_RDWR_CYC;
+        mCyclesUsed+=2*SPR_RDWR_CYC;
 }
 
 INLINE uint32 CSusie::ReadCollision(uint32 hoff)
 {
+        if(mCollPlaneOn)
+        {
+                SUZY_STAT(mStats.coll_reads++);
+                mCyclesUsed+=SPR_RDWR_CYC;
+                return mLineCollisionPlane[hoff];
+        }
+
         const uint16 col_addr=mLineCollisionAddress+(hoff/2);
 
         uint32 data=RAM_PEEK(col_addr);
@@ -816,8 +1578,10 @@ INLINE uint32 CSusie::ReadCollision(uint32 hoff)
                 data&=0x0f;
         }
 
+        SUZY_STAT(mStats.coll_reads++);
+
         // Increment cycle count for the read/modify/write
-        cycles_used+=SPR_RDWR_CYC;
+        mCyclesUsed+=SPR_RDWR_CYC;
 
         return data;
 }
@@ -842,14 +1606,27 @@ INLINE uint32 CSusie::LineGetBits(uint32 bits)
                 // This assumes data comes into LSB and out of MSB
 //              mLineShiftReg&=0x000000ff;      // Has no effect
                 mLineShiftReg<<=24;
+#ifdef WANT_THREADING
+                // Sprite data can be anywhere, even in a buffer the
+                // chain draws to
+                if(mBand)
+                {
+                        BAND_MARK(mBand,mTMPADR.Val16);
+                        BAND_MARK(mBand,(uint16)(mTMPADR.Val16+1));
+                        BAND_MARK(mBand,(uint16)(mTMPADR.Val16+2));
+                }
+#endif
+                if(mCollPlaneDirty)
+                        CollisionPlaneRead(mTMPADR.Val16,3);
                 mLineShiftReg|=RAM_PEEK(mTMPADR.Val16++)<<16;
                 mLineShiftReg|=RAM_PEEK(mTMPADR.Val16++)<<8;
                 mLineShiftReg|=RAM_PEEK(mTMPADR.Val16++);
 
                 mLineShiftRegCount+=24;
+                SUZY_STAT(mStats.bytes+=3);
 
                 // Increment cycle count for the read
-                cycles_used+=3*SPR_RDWR_CYC;
+                mCyclesUsed+=3*SPR_RDWR_CYC;
         }
 
         // Extract the return value
@@ -1078,6 +1855,303 @@ void CSusie::ProcessPixel(uint32 hoff,uint32 pixel)
 	}
 }
 
+//
+// Horizontal repeat pattern for one HSIZACUM start/SPRHSIZ pair. Entry 0
+// is the first pixel of a line, after that only the low byte of the
+// accumulator is carried so entries 1-256 repeat with a period of 256.
+//
+void CSusie::LineSetupRepeat(uint16 start)
+{
+	uint16 acc=start+mSPRHSIZ.Val16;
+
+	mHRepeatStart=start;
+	mHRepeatSize=mSPRHSIZ.Val16;
+	mHRepeatValid=true;
+
+	mHRepeatWidth[0]=acc>>8;
+	mHRepeatAcc[0]=acc&0xff;
+
+	for(int loop=1;loop<=256;loop++)
+	{
+		acc=mHRepeatAcc[loop-1]+mSPRHSIZ.Val16;
+		mHRepeatWidth[loop]=acc>>8;
+		mHRepeatAcc[loop]=acc&0xff;
+	}
+}
+
+//
+// Shadow collision plane, one byte per pixel for the buffer at COLLBAS.
+// Collision writes only go to the plane and mark their line. The lines
+// are packed back into RAM and mCollMirror, a copy of the packed bytes as
+// the plane last saw them, when the chain ends, or earlier if the engine
+// reads SCBs or sprite data from the buffer. Anything else that writes
+// the buffer between sprite chains (CPU, loaders, states, cheats) shows up
+// as a difference against the mirror at the start of the next chain and
+// only those bytes are unpacked again.
+//
+void CSusie::SetCollisionPlane(bool enable)
+{
+	mCollPlaneEnable=enable;
+	mCollPlaneValid=false;
+}
+
+void CSusie::CollisionPlaneSync(void)
+{
+	const uint32 region=SCREEN_HEIGHT*(SCREEN_WIDTH/2);
+	const uint16 vidbas=mVIDBAS.Val16;
+	const uint16 collbas=mCOLLBAS.Val16;
+
+	// Needs a buffer that neither wraps nor shares RAM with the screen
+	if((uint32)collbas+region>0x10000 || (uint16)(collbas-vidbas)<region || (uint16)(vidbas-collbas)<region)
+		return;
+
+	const uint8 *ram=mRamPointer+collbas;
+
+	if(!mCollPlaneValid || mCollPlaneBase!=collbas)
+	{
+		memcpy(mCollMirror,ram,region);
+		for(uint32 loop=0;loop<region;loop++)
+		{
+			mCollPlane[loop*2]=ram[loop]>>4;
+			mCollPlane[loop*2+1]=ram[loop]&0x0f;
+		}
+		mCollPlaneBase=collbas;
+		mCollPlaneValid=true;
+	}
+	else
+	{
+		for(uint32 line=0;line<region;line+=SCREEN_WIDTH/2)
+		{
+			if(!memcmp(mCollMirror+line,ram+line,SCREEN_WIDTH/2))
+				continue;
+
+			for(uint32 loop=line;loop<line+SCREEN_WIDTH/2;loop++)
+			{
+				if(mCollMirror[loop]==ram[loop])
+					continue;
+				mCollMirror[loop]=ram[loop];
+				mCollPlane[loop*2]=ram[loop]>>4;
+				mCollPlane[loop*2+1]=ram[loop]&0x0f;
+			}
+		}
+	}
+
+	mCollPlaneOn=true;
+}
+
+// Resync one byte written by the engine outside WriteCollision()
+void CSusie::CollisionPlaneTouch(uint16 addr)
+{
+	const uint16 offset=addr-mCollPlaneBase;
+
+	if(offset>=SCREEN_HEIGHT*(SCREEN_WIDTH/2))
+		return;
+
+	mCollMirror[offset]=RAM_PEEK(addr);
+	mCollPlane[offset*2]=mCollMirror[offset]>>4;
+	mCollPlane[offset*2+1]=mCollMirror[offset]&0x0f;
+}
+
+// Write back before the engine reads len bytes at addr from the buffer
+INLINE void CSusie::CollisionPlaneRead(uint16 addr,uint32 len)
+{
+	const uint32 region=SCREEN_HEIGHT*(SCREEN_WIDTH/2);
+
+	if((uint16)(addr-mCollPlaneBase)<region || (uint16)(mCollPlaneBase-addr)<len)
+		CollisionPlaneWriteBack();
+}
+
+void CSusie::CollisionPlaneWriteBack(void)
+{
+	for(int line=0;line<SCREEN_HEIGHT;line++)
+	{
+		if(!mCollLineDirty[line])
+			continue;
+		mCollLineDirty[line]=false;
+
+		const uint8 *plane=mCollPlane+line*SCREEN_WIDTH;
+		uint8 *mirror=mCollMirror+line*(SCREEN_WIDTH/2);
+		const uint16 addr=mCollPlaneBase+line*(SCREEN_WIDTH/2);
+
+		for(int loop=0;loop<SCREEN_WIDTH/2;loop++)
+		{
+			const uint8 packed=(plane[loop*2]<<4)|plane[loop*2+1];
+			if(mirror[loop]==packed)
+				continue;
+			mirror[loop]=packed;
+			RAM_POKE(addr+loop,packed);
+		}
+	}
+
+	mCollPlaneDirty=false;
+}
+
+//
+// Collision test and fill for a span of one pixel value on the plane, the
+// same result and cycle count as ReadCollision()/WriteCollision() per pixel.
+// The max and fill loops are kept simple so the compiler can vectorise them.
+//
+INLINE void CSusie::CollisionSpan(int hoff,int hsign,int count,bool read)
+{
+	const int first=(hsign==1) ? hoff : hoff-count+1;
+	uint8 *plane=mLineCollisionPlane+first;
+
+	if(read)
+	{
+		uint8 highest=0;
+		for(int loop=0;loop<count;loop++)
+			highest=(plane[loop]>highest) ? plane[loop] : highest;
+		if(highest>mCollision)
+			mCollision=highest;
+
+		SUZY_STAT(mStats.coll_reads+=count);
+		mCyclesUsed+=count*SPR_RDWR_CYC;
+	}
+
+	memset(plane,mSPRCOLL_Number,count);
+	*mLineCollisionDirty=true;
+	mCollPlaneDirty=true;
+
+	SUZY_STAT(mStats.coll_writes+=count);
+	mCyclesUsed+=count*2*SPR_RDWR_CYC;
+}
+
+//
+// Paint "count" copies of one pixel. Colour 0 is transparent for every
+// type but the two background ones and then nothing is read or written.
+// With the collision plane the screen and collision halves of
+// ProcessPixel() are done separately, the two buffers do not overlap.
+//
+INLINE void CSusie::ProcessSpan(int hoff,int hsign,int count,uint32 pixel)
+{
+	if(!pixel && mSPRCTL0_Type!=sprite_background_shadow && mSPRCTL0_Type!=sprite_background_noncollide)
+		return;
+
+	if(!mCollPlaneOn || count<2)
+	{
+		for(;count;count--)
+		{
+			ProcessPixel(hoff,pixel);
+			hoff+=hsign;
+		}
+		return;
+	}
+
+	bool write=false;
+	bool collide=false;
+	bool read=true;
+
+	switch(mSPRCTL0_Type)
+	{
+		case sprite_background_shadow:
+			write=true;
+			collide=(pixel!=0x0e);
+			read=false;
+			break;
+		case sprite_background_noncollide:
+			write=true;
+			break;
+		case sprite_noncollide:
+			write=true;
+			break;
+		case sprite_boundary:
+			write=(pixel!=0x0f);
+			collide=true;
+			break;
+		case sprite_normal:
+			write=true;
+			collide=true;
+			break;
+		case sprite_boundary_shadow:
+			write=(pixel!=0x0e && pixel!=0x0f);
+			collide=(pixel!=0x0e);
+			break;
+		case sprite_shadow:
+			write=true;
+			collide=(pixel!=0x0e);
+			break;
+		case sprite_xor_shadow:
+			collide=(pixel!=0x0e);
+			for(int loop=0,x=hoff;loop<count;loop++,x+=hsign)
+				WritePixel(x,ReadPixel(x)^pixel);
+			break;
+		default:
+			break;
+	}
+
+	if(write)
+	{
+		for(int loop=0,x=hoff;loop<count;loop++,x+=hsign)
+			WritePixel(x,pixel);
+	}
+
+	if(collide && !mSPRCOLL_Collide && !mSPRSYS_NoCollide)
+		CollisionSpan(hoff,hsign,count,read);
+}
+
+//
+// Render the line set up by LineInit() from the repeat pattern, clipping
+// whole spans instead of testing every output pixel. Leaves the same
+// pixels, HSIZACUM and cycle count as the per pixel loop, including
+// decoding the rest of the line once it has run off the screen edge.
+// Returns true if anything landed on screen.
+//
+bool CSusie::LineRenderSpans(int hoff,int hsign)
+{
+	bool onscreen=false;
+	bool done=false;
+	uint32 pixel;
+	uint32 index=0;
+	uint32 count=0;
+
+	if(!mHRepeatValid || mHRepeatStart!=mHSIZACUM.Val16 || mHRepeatSize!=mSPRHSIZ.Val16)
+		LineSetupRepeat(mHSIZACUM.Val16);
+
+	while((pixel=LineGetPixel())!=LINE_END)
+	{
+		index=count ? 1+((count-1)&0xff) : 0;
+		count++;
+
+		int width=mHRepeatWidth[index];
+
+		if(done || !width)
+			continue;
+
+		// Off screen lead in, only possible before the first pixel drawn
+		int skip=(hsign==1) ? -hoff : hoff-(SCREEN_WIDTH-1);
+		if(skip>0)
+		{
+			if(skip>width) skip=width;
+			hoff+=skip*hsign;
+			width-=skip;
+		}
+
+		int draw=(hsign==1) ? SCREEN_WIDTH-hoff : hoff+1;
+		if(draw>width) draw=width;
+		if(draw>0)
+		{
+			ProcessSpan(hoff,hsign,draw,pixel);
+			hoff+=draw*hsign;
+			width-=draw;
+			onscreen=true;
+		}
+
+		// Ran off the far edge, the rest of the line is only decoded
+		if(width)
+		{
+			if(onscreen)
+				done=true;
+			else
+				hoff+=width*hsign;
+		}
+	}
+
+	if(count)
+		mHSIZACUM.Val16=mHRepeatAcc[index];
+
+	return onscreen;
+}
+
 uint32 CSusie::LineInit(uint32 voff)
 {
 
@@ -1122,6 +2196,9 @@ uint32 CSusie::LineInit(uint32 voff)
 
 	mLineBaseAddress=mVIDBAS.Val16+(voff*(SCREEN_WIDTH/2));
 	mLineCollisionAddress=mCOLLBAS.Val16+(voff*(SCREEN_WIDTH/2));
+	mLineCollisionPlane=mCollPlane+voff*SCREEN_WIDTH;
+	mLineCollisionMirror=mCollMirror+voff*(SCREEN_WIDTH/2);
+	mLineCollisionDirty=mCollLineDirty+voff;
 
 	// Return the offset to the next line
 
@@ -1202,6 +2279,9 @@ uint32 CSusie::LineGetPixel()
 
 void CSusie::Poke(uint32 addr,uint8 data)
 {
+#ifdef WANT_THREADING
+	if(mSpritePending) SpriteSync();
+#endif
 	switch(addr&0xff)
 	{
 		case (TMPADRL&0xff):
@@ -1542,6 +2622,10 @@ uint8 CSusie::Peek(uint32 addr)
 {
 	uint8	retval=0;
 
+#ifdef WANT_THREADING
+	if(mSpritePending) SpriteSync();
+#endif
+
 	switch(addr&0xff)
 	{
 		case (TMPADRL&0xff):
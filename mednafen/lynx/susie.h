@@ -46,6 +46,11 @@
 #define SUSIE_H
 
 class CSystem;
+#ifdef WANT_THREADING
+struct SpriteThreads;
+struct SpriteBand;
+struct SpriteRegs;
+#endif
 
 #define SUSIE_START		0xfc00
 #define SUSIE_SIZE		0x100
@@ -53,6 +58,10 @@ class CSystem;
 #define SCREEN_WIDTH	160
 #define SCREEN_HEIGHT	102
 
+#define SPRITE_BANDS_MAX	4
+#define SPRITE_CHAIN_MAX	4096	// SCBs before a chain is taken as looped
+#define SCB_SIZE_MAX		27	// Control to palette, every optional field loaded
+
 #define LINE_END		0x80
 
 //
@@ -292,6 +301,25 @@ typedef struct
 	};
 }TMATHNP;
 
+#ifdef WANT_SUZY_STATS
+// Sprite engine counters, accumulated over one frame
+typedef struct
+{
+	uint32	scbs;			// SCBs fetched
+	uint32	skipped;		// of which skip sprites
+	uint32	drawn[8];		// sprites processed, by sprite type
+	uint32	pixels;			// video pixel writes
+	uint32	coll_reads;		// collision buffer reads
+	uint32	coll_writes;	// collision buffer writes
+	uint32	bytes;			// sprite data bytes fetched by the line decoder
+	uint32	cycles;			// engine cycles returned by PaintSprites()
+}TSUZYSTATS;
+
+#define SUZY_STAT(x)	x
+#else
+#define SUZY_STAT(x)
+#endif
+
 
 class CSusie : public CLynxBase
 {
@@ -311,6 +339,29 @@ class CSusie : public CLynxBase
 		uint32	GetButtonData(void) {return mJOYSTICK.Byte+(mSWITCHES.Byte<<8);};
 
 		uint32	PaintSprites(void);
+		void	SetCollisionPlane(bool enable) MDFN_COLD;
+
+#ifdef WANT_THREADING
+		// Optional sprite worker thread. PaintSpritesAsync() hands the SCB
+		// chain to the worker, SpriteSync() is the completion barrier and
+		// adds the engine cycle count onto gSuzieDoneTime once it is known.
+		void	SetSpriteThread(bool enable) MDFN_COLD;
+		bool	PaintSpritesAsync(void);
+		void	SpriteSync(void);
+		bool	SpriteWaitUntil(uint32 cycles);
+		bool	SpritesPending(void) {return mSpritePending;};
+		uint32	SpriteProgress(void);
+
+		// Optional banded rasteriser, every band walks the whole SCB chain
+		// but only renders its own 8 line stripes of the screen. Results
+		// are merged in sprite order, see PaintSpritesBanded().
+		void	SetSpriteBands(int count) MDFN_COLD;
+#endif
+
+#ifdef WANT_SUZY_STATS
+		void	EndStatsFrame(void) {mFrameStats=mStats;memset(&mStats,0,sizeof(mStats));};
+		void	GetStats(TSUZYSTATS *stats) {*stats=mFrameStats;};
+#endif
 
 		int	StateAction(StateMem *sm, int load, int data_only);
 
@@ -320,6 +371,14 @@ class CSusie : public CLynxBase
 		uint32	LineInit(uint32 voff);
 		uint32	LineGetPixel(void);
 		uint32	LineGetBits(uint32 bits);
+		void	LineSetupRepeat(uint16 start);
+		bool	LineRenderSpans(int hoff,int hsign);
+		void	ProcessSpan(int hoff,int hsign,int count,uint32 pixel);
+		void	CollisionPlaneSync(void);
+		void	CollisionPlaneTouch(uint16 addr);
+		void	CollisionPlaneRead(uint16 addr,uint32 len);
+		void	CollisionPlaneWriteBack(void);
+		void	CollisionSpan(int hoff,int hsign,int count,bool read);
 
 		void	ProcessPixel(uint32 hoff,uint32 pixel);
 		void	WritePixel(uint32 hoff,uint32 pixel);
@@ -327,6 +386,18 @@ class CSusie : public CLynxBase
 		void	WriteCollision(uint32 hoff,uint32 pixel);
 		uint32	ReadCollision(uint32 hoff);
 
+		uint32	PaintSpriteChain(void);
+
+#ifdef WANT_THREADING
+		bool	SpriteChainEnds(void);
+		void	SpriteWorker(void);
+		void	SpriteBandWorker(int index,uint32 generation);
+		uint32	PaintSpritesBanded(void);
+		void	SaveSpriteRegs(SpriteRegs *regs);
+		void	LoadSpriteRegs(const SpriteRegs *regs);
+		void	BandSaveLine(int voff);
+#endif
+
 	private:
 		CSystem&	mSystem;
 
@@ -413,16 +484,53 @@ class CSusie : public CLynxBase
 		int			mCollision;
 
 		uint8		*mRamPointer;
+		uint32		*mRamPages;
 
 		uint32		mLineBaseAddress;
 		uint32		mLineCollisionAddress;
 
+		// Horizontal repeat pattern cache, see LineSetupRepeat()
+		bool		mHRepeatValid;
+		uint16		mHRepeatStart;
+		uint16		mHRepeatSize;
+		uint8		mHRepeatWidth[257];
+		uint8		mHRepeatAcc[257];
+
+		// Unpacked collision buffer, see CollisionPlaneSync()
+		bool		mCollPlaneEnable;
+		bool		mCollPlaneOn;		// Usable for the current chain
+		bool		mCollPlaneValid;
+		bool		mCollPlaneDirty;	// Written since the last write-back
+		uint16		mCollPlaneBase;
+		uint8		*mLineCollisionPlane;
+		uint8		*mLineCollisionMirror;
+		bool		*mLineCollisionDirty;
+		bool		mCollLineDirty[SCREEN_HEIGHT];
+		uint8		mCollPlane[SCREEN_HEIGHT*SCREEN_WIDTH];
+		uint8		mCollMirror[SCREEN_HEIGHT*(SCREEN_WIDTH/2)];
+
 	        int hquadoff, vquadoff;
 
 		// Joystick switches
 
 		TJOYSTICK	mJOYSTICK;
 		TSWITCHES	mSWITCHES;
+
+		uint32		mCyclesUsed;
+
+#ifdef WANT_SUZY_STATS
+		TSUZYSTATS	mStats;
+		TSUZYSTATS	mFrameStats;
+#endif
+
+#ifdef WANT_THREADING
+		// Worker and band threads live behind a pointer so that band copies
+		// of Susie can be made, only the owner (mThreads->owner) tears them
+		// down. mSpritePending is only touched by the CPU thread.
+		SpriteThreads	*mThreads;
+		SpriteBand	*mBand;
+		bool		mSpritePending;
+#endif
 };
 
 #endif
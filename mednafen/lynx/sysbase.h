@@ -62,6 +62,7 @@ class CSystemBase
 		virtual uint16	PeekW_CPU(uint32 addr)=0;
 
 		virtual uint8*	GetRamPointer(void)=0;
+		virtual uint32*	GetRamPagePointer(void)=0;
 
 };
 
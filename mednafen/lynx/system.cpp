@@ -151,6 +151,9 @@ CSystem::~CSystem()
 
 void CSystem::Reset(void)
 {
+#ifdef WANT_THREADING
+	mSusie->SpriteSync();
+#endif
 	mMikie->startTS -= gSystemCycleCount;
 	gSystemCycleCount=0;
 	gNextTimerEvent=0;
@@ -245,6 +248,101 @@ void CloseGame(void)
 }
 
 static uint8 *chee;
+
+static void CheatWritten(uint32 addr)
+{
+ lynxie->mRam->MarkDirty(addr);
+}
+
+// A frame ends when timer 2 runs out, or after LYNX_FRAME_CYCLES_MAX cycles
+// with the display timers stopped. One the timers stretch mid-frame is cut
+// LYNX_FRAME_CYCLES_SLACK past the length they were set for at its start,
+// and a mid-frame audio sync chunk likewise past its lines. The sound
+// buffers are sized from those limits.
+#define LYNX_FRAME_CYCLES_MAX	700000
+#define LYNX_FRAME_CYCLES_SLACK	(HANDY_SYSTEM_FREQ / 200)
+// Headroom for the last Update() running past the limit
+#define LYNX_SOUND_BUFFER_SLACK_MSEC	5
+
+// The mix buffer is read at every sync, the voice buffers once per frame
+static uint32 MixBufferMsec;
+static uint32 VoiceBufferMsec;
+
+static uint32 FrameCyclesLimit(void)
+{
+ uint32 frame = lynxie->mMikie->FrameCycles();
+
+ if(!frame || frame > LYNX_FRAME_CYCLES_MAX - LYNX_FRAME_CYCLES_SLACK)
+  return LYNX_FRAME_CYCLES_MAX;
+
+ return frame + LYNX_FRAME_CYCLES_SLACK;
+}
+
+static uint32 ChunkCyclesLimit(uint32 frame_limit)
+{
+ uint32 chunk = lynxie->mMikie->LineCycles() * lynxie->mMikie->mSyncLines;
+
+ if(!chunk || chunk > frame_limit - LYNX_FRAME_CYCLES_SLACK)
+  return frame_limit;
+
+ return chunk + LYNX_FRAME_CYCLES_SLACK;
+}
+
+static uint32 SoundBufferMsec(uint32 cycles)
+{
+ return (cycles * 1000 + HANDY_SYSTEM_FREQ - 1) / HANDY_SYSTEM_FREQ + LYNX_SOUND_BUFFER_SLACK_MSEC;
+}
+
+// Setting the length clears a buffer, only done when it changes
+static void SetSoundBuffers(long rate, uint32 mix_msec, uint32 voice_msec, bool format_changed)
+{
+ CMikie *mikie = lynxie->mMikie;
+
+ if(format_changed || mix_msec != MixBufferMsec)
+ {
+  mikie->mikbuf.set_sample_rate(rate, mix_msec);
+  mikie->mikbuf.clock_rate((long int)(16000000 / 4));
+  mikie->mikbuf.bass_freq(60);
+  mikie->miksynth.volume(0.50);
+  MixBufferMsec = mix_msec;
+ }
+
+ if(format_changed || voice_msec != VoiceBufferMsec)
+ {
+  for(int x = 0; x < 4; x++)
+  {
+   mikie->voicebuf[x].set_sample_rate(rate, voice_msec);
+   mikie->voicebuf[x].clock_rate((long int)(16000000 / 4));
+   mikie->voicebuf[x].bass_freq(60);
+  }
+  VoiceBufferMsec = voice_msec;
+ }
+}
+
+// Hands the sound so far to the driver and starts a new Blip frame, startTS
+// moves up to the end of what was read and MasterCycles counts it. The next
+// chunk is written from the start of SoundBuf again.
+static void AudioMidSync(EmulateSpecStruct *espec)
+{
+ CMikie *mikie = lynxie->mMikie;
+ uint32 ts = (gSystemCycleCount - mikie->startTS) >> 2;
+
+ mikie->AudioCatchUp(gSystemCycleCount);
+ mikie->mikbuf.end_frame(ts);
+ espec->SoundBufSize += mikie->mikbuf.read_samples(espec->SoundBuf + espec->SoundBufSize * 2, espec->SoundBufMaxSize - espec->SoundBufSize * 2) / 2;
+
+ if(mikie->mVoiceOutput)
+  mikie->VoiceEndFrame(ts);
+
+ mikie->startTS += ts << 2;
+ espec->MasterCycles += ts << 2;
+
+ MDFN_MidSync(espec);
+
+ espec->SoundBufSize = 0;
+ espec->SoundBufSizeALMS = 0;
+}
+
 void Emulate(EmulateSpecStruct *espec)
 {
  espec->DisplayRect.x = 0;
@@ -255,19 +353,16 @@ void Emulate(EmulateSpecStruct *espec)
  if(espec->VideoFormatChanged)
   lynxie->DisplaySetAttributes(espec->surface->bpp);
 
- if(espec->SoundFormatChanged)
- {
-  lynxie->mMikie->mikbuf.set_sample_rate(espec->SoundRate ? espec->SoundRate : 44100, 60);
-  lynxie->mMikie->mikbuf.clock_rate((long int)(16000000 / 4));
-  lynxie->mMikie->mikbuf.bass_freq(60);
-  lynxie->mMikie->miksynth.volume(0.50);
- }
+ uint32 frame_limit = FrameCyclesLimit();
+ uint32 chunk_limit = (espec->SoundBuf && lynxie->mMikie->mSyncLines) ? ChunkCyclesLimit(frame_limit) : frame_limit;
+
+ SetSoundBuffers(espec->SoundRate ? espec->SoundRate : 44100, SoundBufferMsec(chunk_limit), SoundBufferMsec(frame_limit), espec->SoundFormatChanged);
 
  uint16 butt_data = chee[0] | (chee[1] << 8);
 
  lynxie->SetButtonData(butt_data);
 
- MDFNMP_ApplyPeriodicCheats();
+ MDFNMP_ApplyPeriodicCheats(CheatWritten);
 
  memset(LynxLineDrawn, 0, sizeof(LynxLineDrawn[0]) * 102);
 
@@ -276,12 +371,50 @@ void Emulate(EmulateSpecStruct *espec)
  lynxie->mMikie->mpDisplayCurrentLine = 0;
  lynxie->mMikie->startTS = gSystemCycleCount;
 
- while(lynxie->mMikie->mpDisplayCurrent && (gSystemCycleCount - lynxie->mMikie->startTS) < 700000)
+ // No sound buffer means the frontend discards audio, skip synthesis
+ lynxie->mMikie->SetSoundEnabled(espec->SoundBuf != NULL);
+
+ if(espec->SoundBuf && lynxie->mMikie->mVoiceOutput)
+  lynxie->mMikie->VoiceBeginFrame();
+
+ espec->SoundBufSize = 0;
+ espec->SoundBufSizeALMS = 0;
+ espec->MasterCycles = 0;
+ espec->MasterCyclesALMS = 0;
+
+ if(espec->SoundBuf && lynxie->mMikie->mSyncLines)
+ {
+  // MasterCycles holds the cycles already synced, startTS is the last sync
+  uint32 sync_line = lynxie->mMikie->mLineCount + lynxie->mMikie->mSyncLines;
+
+  while(lynxie->mMikie->mpDisplayCurrent && (gSystemCycleCount - lynxie->mMikie->startTS) + espec->MasterCycles < frame_limit)
+  {
+   lynxie->Update();
+
+   if((int32)(lynxie->mMikie->mLineCount - sync_line) >= 0 || gSystemCycleCount - lynxie->mMikie->startTS >= chunk_limit)
+   {
+    AudioMidSync(espec);
+    sync_line = lynxie->mMikie->mLineCount + lynxie->mMikie->mSyncLines;
+   }
+  }
+ }
+ else while(lynxie->mMikie->mpDisplayCurrent && (gSystemCycleCount - lynxie->mMikie->startTS) < frame_limit)
  {
   lynxie->Update();
 //  printf("%d ", gSystemCycleCount - lynxie->mMikie->startTS);
  }
 
+#ifdef WANT_THREADING
+ // RAM is visible to the frontend between frames
+ lynxie->SpriteSync();
+#endif
+
+#ifdef WANT_SUZY_STATS
+ lynxie->mSusie->EndStatsFrame();
+#endif
+
+ // Skipped frames convert no lines, leave the surface alone entirely
+ if(!espec->skip)
  {
 	 // FIXME, we should integrate this into mikie.*
 	 uint32 color_black;
@@ -319,15 +452,19 @@ void Emulate(EmulateSpecStruct *espec)
 	 }
  }
 
- espec->MasterCycles = gSystemCycleCount - lynxie->mMikie->startTS;
+ // Lazy audio timers still owe the borrows up to the end of the frame
+ lynxie->mMikie->AudioCatchUp(gSystemCycleCount);
+
+ espec->MasterCycles += gSystemCycleCount - lynxie->mMikie->startTS;
 
  if(espec->SoundBuf)
  {
   lynxie->mMikie->mikbuf.end_frame((gSystemCycleCount - lynxie->mMikie->startTS) >> 2);
-  espec->SoundBufSize = lynxie->mMikie->mikbuf.read_samples(espec->SoundBuf, espec->SoundBufMaxSize) / 2; // divide by nr audio chn
+  espec->SoundBufSize += lynxie->mMikie->mikbuf.read_samples(espec->SoundBuf + espec->SoundBufSize * 2, espec->SoundBufMaxSize - espec->SoundBufSize * 2) / 2; // divide by nr audio chn
+
+  if(lynxie->mMikie->mVoiceOutput)
+   lynxie->mMikie->VoiceEndFrame((gSystemCycleCount - lynxie->mMikie->startTS) >> 2);
  }
- else
-  espec->SoundBufSize = 0;
 }
 
 void SetInput(unsigned port, const char *type, uint8 *ptr)
@@ -355,6 +492,10 @@ static void TransformInput(void)
 
 int StateAction(StateMem *sm, int load, int data_only)
 {
+#ifdef WANT_THREADING
+ lynxie->SpriteSync();
+#endif
+
  SFORMAT SystemRegs[] =
  {
 	SFVAR(gSuzieDoneTime),
@@ -375,6 +516,10 @@ int StateAction(StateMem *sm, int load, int data_only)
  ret &= lynxie->mCart->StateAction(sm, load, data_only);
  ret &= lynxie->mMikie->StateAction(sm, load, data_only);
  ret &= lynxie->mCpu->StateAction(sm, load, data_only);
+
+ if(load)
+  lynxie->mRam->MarkAllDirty();
+
  return ret;
 }
 
@@ -74,6 +74,7 @@
 	uint32	gSystemNMI=false;
 	uint32	gSystemCPUSleep=false;
 	uint32	gSystemHalt=false;
+	uint32	gRamEpoch=0;
 #else
 	extern uint32	gSystemCycleCount;
 	extern uint32	gSuzieDoneTime;
@@ -83,6 +84,7 @@
 	extern uint32	gSystemNMI;
 	extern uint32	gSystemCPUSleep;
 	extern uint32	gSystemHalt;
+	extern uint32	gRamEpoch;
 #endif
 
 //
@@ -129,6 +131,15 @@ class CSystem : public CSystemBase
 			{
 				mMikie->Update();
 			}
+#ifdef WANT_THREADING
+			//
+			// The CPU can touch any RAM so it never runs alongside the sprite worker
+			//
+			if(!gSystemCPUSleep && mSusie->SpritesPending())
+			{
+				mSusie->SpriteSync();
+			}
+#endif
 			//
 			// Step the processor through 1 instruction
 			//
@@ -192,10 +203,22 @@ class CSystem : public CSystemBase
 		void	ComLynxCable(int status) { mMikie->ComLynxCable(status); };
 		void	ComLynxRxData(int data)  { mMikie->ComLynxRxData(data); };
 		void	ComLynxTxCallback(void (*function)(int data,uint32 objref),uint32 objref) { mMikie->ComLynxTxCallback(function,objref); };
+		void	SetLazyAudio(bool enable) {mMikie->SetLazyAudio(enable);};
+		void	SetAudioSyncLines(uint32 lines) {mMikie->mSyncLines=lines;};
 
 // Suzy system interfacing
 
 		uint32	PaintSprites(void) {return mSusie->PaintSprites();};
+		void	SetCollisionPlane(bool enable) {mSusie->SetCollisionPlane(enable);};
+#ifdef WANT_THREADING
+		void	SetSpriteThread(bool enable) {mSusie->SetSpriteThread(enable);};
+		bool	PaintSpritesAsync(void) {return mSusie->PaintSpritesAsync();};
+		bool	SpritesPending(void) {return mSusie->SpritesPending();};
+		void	SpriteSync(void) {mSusie->SpriteSync();};
+		uint32	SpriteProgress(void) {return mSusie->SpriteProgress();};
+		bool	SpriteWaitUntil(uint32 cycles) {return mSusie->SpriteWaitUntil(cycles);};
+		void	SetSpriteBands(int count) {mSusie->SetSpriteBands(count);};
+#endif
 
 // Miscellaneous
 
@@ -203,6 +226,8 @@ class CSystem : public CSystemBase
 		uint32	GetButtonData(void) {return mSusie->GetButtonData();};
 		void	SetCycleBreakpoint(uint32 breakpoint) {mCycleCountBreakpoint=breakpoint;};
 		uint8*	GetRamPointer(void) {return mRam->GetRamPointer();};
+		uint32	CRC32(void) {return (mFileType==HANDY_FILETYPE_HOMEBREW)?mRam->CRC32():mCart->CRC32();};
+		uint32*	GetRamPagePointer(void) {return mRam->GetPagePointer();};
 
 	public:
 		uint32			mCycleCountBreakpoint;
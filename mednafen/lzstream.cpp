@@ -0,0 +1,314 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+
+#include "mednafen.h"
+#include "mednafen-endian.h"
+#include "lzstream.h"
+
+static const char lzs_magic[8] = { 'M', 'D', 'F', 'N', 'L', 'Z', 'S', '1' };
+
+static INLINE uint32_t read32(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, 4);
+   return v;
+}
+
+static INLINE uint32_t lzs_hash(uint32_t v)
+{
+   return (v * 2654435761U) >> (32 - LZS_HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *out, uint32_t len)
+{
+   while(len >= 255)
+   {
+      *out++ = 255;
+      len -= 255;
+   }
+   *out++ = len;
+   return out;
+}
+
+static uint8_t *put_sequence(uint8_t *out, const uint8_t *lit, uint32_t lit_len, uint32_t dist, uint32_t match_len)
+{
+   uint8_t *token = out++;
+   uint32_t ml = match_len ? match_len - LZS_MIN_MATCH : 0;
+
+   *token = ((lit_len < 15) ? lit_len : 15) << 4 | ((ml < 15) ? ml : 15);
+
+   if(lit_len >= 15)
+      out = put_length(out, lit_len - 15);
+   memcpy(out, lit, lit_len);
+   out += lit_len;
+
+   if(match_len)
+   {
+      *out++ = dist;
+      *out++ = dist >> 8;
+      if(ml >= 15)
+         out = put_length(out, ml - 15);
+   }
+   return out;
+}
+
+/* Greedy, a 4 byte hash into the last position seen, the search steps
+ * further apart the longer it goes without a match. */
+static uint32_t lzs_compress(LZSWriter *w, const uint8_t *in, uint32_t len, uint8_t *out)
+{
+   uint8_t *const out_start = out;
+   uint32_t ip = 0, anchor = 0;
+
+   memset(w->hash, 0, sizeof(w->hash));
+
+   while(ip + LZS_MIN_MATCH <= len)
+   {
+      uint32_t h = lzs_hash(read32(in + ip));
+      uint32_t ref = w->hash[h];
+
+      w->hash[h] = ip + 1;
+
+      if(!ref || ip - (ref - 1) > 0xFFFF || read32(in + ref - 1) != read32(in + ip))
+      {
+         ip += 1 + ((ip - anchor) >> 6);
+         continue;
+      }
+      ref--;
+
+      uint32_t match_len = LZS_MIN_MATCH;
+      while(ip + match_len < len && in[ref + match_len] == in[ip + match_len])
+         match_len++;
+
+      out = put_sequence(out, in + anchor, ip - anchor, ip - ref, match_len);
+      ip += match_len;
+      anchor = ip;
+   }
+
+   out = put_sequence(out, in + anchor, len - anchor, 0, 0);
+   return out - out_start;
+}
+
+static bool lzs_decompress(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t out_len)
+{
+   const uint8_t *const in_end = in + in_len;
+   uint32_t op = 0;
+
+   while(in < in_end)
+   {
+      uint8_t token = *in++;
+      uint32_t lit_len = token >> 4;
+      uint32_t match_len = token & 0xF;
+
+      if(lit_len == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if(in >= in_end)
+               return false;
+            b = *in++;
+            lit_len += b;
+         } while(b == 255);
+      }
+
+      if(lit_len > (uint32_t)(in_end - in) || lit_len > out_len - op)
+         return false;
+      memcpy(out + op, in, lit_len);
+      in += lit_len;
+      op += lit_len;
+
+      if(in == in_end)
+         break;
+
+      if(in_end - in < 2)
+         return false;
+      uint32_t dist = in[0] | (in[1] << 8);
+      in += 2;
+
+      if(match_len == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if(in >= in_end)
+               return false;
+            b = *in++;
+            match_len += b;
+         } while(b == 255);
+      }
+      match_len += LZS_MIN_MATCH;
+
+      if(!dist || dist > op || match_len > out_len - op)
+         return false;
+
+      /* May overlap, byte by byte */
+      for(uint32_t i = 0; i < match_len; i++, op++)
+         out[op] = out[op - dist];
+   }
+
+   return op == out_len;
+}
+
+static bool lzs_flush(LZSWriter *w)
+{
+   uint8_t *const hdr = w->out;
+   uint32_t raw_len = w->in_len;
+   uint32_t coded_len = 0;
+
+   if(raw_len)
+      coded_len = lzs_compress(w, w->in, raw_len, w->out + 8);
+
+   if(coded_len >= raw_len)
+   {
+      coded_len = raw_len;
+      memcpy(w->out + 8, w->in, raw_len);
+   }
+
+   MDFN_en32lsb(hdr, raw_len);
+   MDFN_en32lsb(hdr + 4, coded_len);
+
+   w->in_len = 0;
+
+   if(!w->write(w->opaque, w->out, 8 + coded_len))
+      w->failed = true;
+
+   return !w->failed;
+}
+
+void LZS_WriterInit(LZSWriter *w, bool (*write)(void *opaque, const uint8_t *buffer, uint32_t len), void *opaque)
+{
+   w->write  = write;
+   w->opaque = opaque;
+   w->in_len = 0;
+   w->failed = !write(opaque, (const uint8_t*)lzs_magic, sizeof(lzs_magic));
+}
+
+bool LZS_Write(void *w_p, const uint8_t *buffer, uint32_t len)
+{
+   LZSWriter *w = (LZSWriter*)w_p;
+
+   while(len && !w->failed)
+   {
+      uint32_t n = LZS_BLOCK_SIZE - w->in_len;
+
+      if(n > len)
+         n = len;
+
+      memcpy(w->in + w->in_len, buffer, n);
+      w->in_len += n;
+      buffer += n;
+      len -= n;
+
+      if(w->in_len == LZS_BLOCK_SIZE)
+         lzs_flush(w);
+   }
+
+   return !w->failed;
+}
+
+bool LZS_WriterFinish(LZSWriter *w)
+{
+   if(w->in_len && !lzs_flush(w))
+      return false;
+
+   /* End of stream */
+   return lzs_flush(w);
+}
+
+void LZS_ReaderInit(LZSReader *r, uint32_t (*read)(void *opaque, uint8_t *buffer, uint32_t len), void *opaque)
+{
+   r->read    = read;
+   r->opaque  = opaque;
+   r->pos     = 0;
+   r->len     = 0;
+   r->started = false;
+   r->ended   = false;
+}
+
+static bool lzs_next_block(LZSReader *r)
+{
+   uint8_t hdr[8];
+
+   if(!r->started)
+   {
+      if(r->read(r->opaque, hdr, 8) != 8 || memcmp(hdr, lzs_magic, 8))
+         return false;
+      r->started = true;
+   }
+
+   if(r->read(r->opaque, hdr, 8) != 8)
+      return false;
+
+   uint32_t raw_len = MDFN_de32lsb(hdr);
+   uint32_t coded_len = MDFN_de32lsb(hdr + 4);
+
+   if(!raw_len)
+   {
+      r->ended = true;
+      return false;
+   }
+
+   if(raw_len > LZS_BLOCK_SIZE || coded_len > LZS_CODED_MAX || coded_len > raw_len)
+      return false;
+
+   if(coded_len == raw_len)
+   {
+      if(r->read(r->opaque, r->block, raw_len) != raw_len)
+         return false;
+   }
+   else
+   {
+      if(r->read(r->opaque, r->coded, coded_len) != coded_len)
+         return false;
+      if(!lzs_decompress(r->coded, coded_len, r->block, raw_len))
+         return false;
+   }
+
+   r->pos = 0;
+   r->len = raw_len;
+   return true;
+}
+
+uint32_t LZS_Read(void *r_p, uint8_t *buffer, uint32_t len)
+{
+   LZSReader *r = (LZSReader*)r_p;
+   uint32_t done = 0;
+
+   while(done < len)
+   {
+      if(r->pos == r->len && (r->ended || !lzs_next_block(r)))
+         break;
+
+      uint32_t n = r->len - r->pos;
+
+      if(n > len - done)
+         n = len - done;
+
+      memcpy(buffer + done, r->block + r->pos, n);
+      r->pos += n;
+      done += n;
+   }
+
+   return done;
+}
+
+bool LZS_IsStream(const uint8_t *data, uint32_t len)
+{
+   return len >= sizeof(lzs_magic) && !memcmp(data, lzs_magic, sizeof(lzs_magic));
+}
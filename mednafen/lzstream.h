@@ -0,0 +1,61 @@
+#ifndef _LZSTREAM_H
+#define _LZSTREAM_H
+
+#include <stdint.h>
+
+/* Streaming LZ77 coder for savestates.
+ *
+ * The stream is the magic "MDFNLZS1" and then blocks of at most
+ * LZS_BLOCK_SIZE bytes, each an 8 byte header of the raw and the coded
+ * length (both 32 bit LSB first) and the coded bytes. A coded length
+ * equal to the raw one means the block is stored as is. A raw length of
+ * 0 ends the stream.
+ *
+ * A coded block is a series of sequences, each a token byte holding the
+ * literal count in its high nibble and the match length minus
+ * LZS_MIN_MATCH in its low one, 15 meaning more length bytes follow
+ * (each added, 255 meaning another), the literals, then a 16 bit LSB
+ * first match distance and the extra match length bytes. The last
+ * sequence of a block has literals only.
+ *
+ * Only one block is held in memory at a time either way. */
+
+#define LZS_BLOCK_SIZE  32768
+#define LZS_MIN_MATCH   4
+#define LZS_HASH_BITS   12
+#define LZS_CODED_MAX   (LZS_BLOCK_SIZE + LZS_BLOCK_SIZE / 255 + 16)
+
+typedef struct
+{
+   bool (*write)(void *opaque, const uint8_t *buffer, uint32_t len);
+   void *opaque;
+   uint32_t in_len;
+   bool failed;
+   uint32_t hash[1 << LZS_HASH_BITS];
+   uint8_t in[LZS_BLOCK_SIZE];
+   uint8_t out[8 + LZS_CODED_MAX];
+} LZSWriter;
+
+typedef struct
+{
+   uint32_t (*read)(void *opaque, uint8_t *buffer, uint32_t len);
+   void *opaque;
+   uint32_t pos;
+   uint32_t len;
+   bool started;
+   bool ended;
+   uint8_t block[LZS_BLOCK_SIZE];
+   uint8_t coded[LZS_CODED_MAX];
+} LZSReader;
+
+void LZS_WriterInit(LZSWriter *w, bool (*write)(void *opaque, const uint8_t *buffer, uint32_t len), void *opaque);
+bool LZS_Write(void *w, const uint8_t *buffer, uint32_t len);
+bool LZS_WriterFinish(LZSWriter *w);
+
+void LZS_ReaderInit(LZSReader *r, uint32_t (*read)(void *opaque, uint8_t *buffer, uint32_t len), void *opaque);
+uint32_t LZS_Read(void *r, uint8_t *buffer, uint32_t len);
+
+/* True if data starts like a stream */
+bool LZS_IsStream(const uint8_t *data, uint32_t len);
+
+#endif
@@ -377,7 +377,7 @@ static bool TestConditions(const char *string)
  return(passed);
 }
 
-void MDFNMP_ApplyPeriodicCheats(void)
+void MDFNMP_ApplyPeriodicCheats(void (*written)(uint32 addr))
 {
  std::vector<CHEATF>::iterator chit;
 
@@ -405,6 +405,9 @@ void MDFNMP_ApplyPeriodicCheats(void)
        tmpval >>= x * 8;
 
       RAMPtrs[page][(chit->addr + x) % PageSize] = tmpval;
+
+      if(written)
+       written(chit->addr + x);
      }
    }
   }
@@ -22,6 +22,7 @@ void MDFNMP_Kill(void);
 void MDFNMP_InstallReadPatches(void);
 void MDFNMP_RemoveReadPatches(void);
 
-void MDFNMP_ApplyPeriodicCheats(void);
+// written, if not NULL, is called with the address of each byte patched
+void MDFNMP_ApplyPeriodicCheats(void (*written)(uint32 addr) = NULL);
 
 #endif
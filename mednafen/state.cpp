@@ -32,6 +32,14 @@
 
 static int32_t smem_read(StateMem *st, void *buffer, uint32_t len)
 {
+   if (st->read)
+   {
+      if (st->read(st->opaque, (uint8_t*)buffer, len) != len)
+         return 0;
+      st->loc += len;
+      return(len);
+   }
+
    if ((len + st->loc) > st->len)
       return 0;
 
@@ -43,8 +51,23 @@ static int32_t smem_read(StateMem *st, void *buffer, uint32_t len)
 
 static int32_t smem_write(StateMem *st, void *buffer, uint32_t len)
 {
+   if (st->write)
+   {
+      if (!st->write(st->opaque, (const uint8_t*)buffer, len))
+         st->overflow = 1;
+      st->loc += len;
+      st->len = st->loc;
+      return(len);
+   }
+
    if ((len + st->loc) > st->malloced)
    {
+      if (st->fixed)
+      {
+         st->overflow = 1;
+         return 0;
+      }
+
       uint32_t newsize = (st->malloced >= 32768) ? st->malloced : (st->initial_malloc ? st->initial_malloc : 32768);
 
       while(newsize < (len + st->loc))
@@ -52,7 +75,8 @@ static int32_t smem_write(StateMem *st, void *buffer, uint32_t len)
       st->data = (uint8_t *)realloc(st->data, newsize);
       st->malloced = newsize;
    }
-   memcpy(st->data + st->loc, buffer, len);
+   if (st->data)
+      memcpy(st->data + st->loc, buffer, len);
    st->loc += len;
 
    if (st->loc > st->len)
@@ -63,6 +87,24 @@ static int32_t smem_write(StateMem *st, void *buffer, uint32_t len)
 
 static int32_t smem_seek(StateMem *st, uint32_t offset, int whence)
 {
+   // A stream can only skip forward
+   if (st->read || st->write)
+   {
+      uint8_t skip[256];
+
+      if (whence != SEEK_CUR || (int32_t)offset < 0 || st->write)
+         return(-1);
+
+      while (offset)
+      {
+         uint32_t len = (offset < sizeof(skip)) ? offset : sizeof(skip);
+         if (smem_read(st, skip, len) != (int32_t)len)
+            return(-1);
+         offset -= len;
+      }
+      return(0);
+   }
+
    switch(whence)
    {
       case SEEK_SET: st->loc = offset; break;
@@ -179,6 +221,17 @@ static bool SubWrite(StateMem *st, SFORMAT *sf, const char *name_prefix = NULL)
    return true;
 }
 
+/* A streamed save can't come back to patch in sizes. MDFNSS_CountSM()
+ * keeps each section's size and the total here, a streamed save writes
+ * them ahead of the data and checks the data against them. */
+#define STREAM_SECTIONS_MAX 64
+
+static uint32_t stream_sizes[STREAM_SECTIONS_MAX];
+static uint32_t stream_sections;
+static uint32_t stream_total;
+static bool stream_counting;
+static uint32_t stream_next;
+
 static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
 {
    int32_t data_start_pos;
@@ -192,6 +245,23 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
 
    smem_write(st, sname_tmp, 32);
 
+   if(st->write)
+   {
+      if(stream_next >= stream_sections)
+         return(0);
+
+      uint32_t size = stream_sizes[stream_next++];
+
+      smem_write32le(st, size);
+
+      data_start_pos = st->loc;
+
+      if(!SubWrite(st, sf) || st->loc - data_start_pos != size)
+         return(0);
+
+      return(size);
+   }
+
    smem_write32le(st, 0);                // We'll come back and write this later.
 
    data_start_pos = st->loc;
@@ -205,6 +275,13 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
    smem_write32le(st, end_pos - data_start_pos);
    smem_seek(st, end_pos, SEEK_SET);
 
+   if(stream_counting)
+   {
+      if(stream_sections >= STREAM_SECTIONS_MAX)
+         return(0);
+      stream_sizes[stream_sections++] = end_pos - data_start_pos;
+   }
+
    return(end_pos - data_start_pos);
 }
 
@@ -238,9 +315,53 @@ static SFORMAT *FindSF(const char *name, SFORMAT *sf)
    return NULL;
 }
 
+/* Walks an SFORMAT table in the order SubWrite() saves it, following
+ * links, so a state from the same build can be matched field by field. */
+#define SF_CURSOR_DEPTH 8
+
+typedef struct
+{
+   SFORMAT *stack[SF_CURSOR_DEPTH];
+   int depth;
+} SFCursor;
+
+static SFORMAT *NextSF(SFCursor *cur)
+{
+   while (cur->depth >= 0)
+   {
+      SFORMAT *sf = cur->stack[cur->depth];
+
+      if (!sf->size && !sf->name)
+      {
+         cur->depth--;
+         continue;
+      }
+
+      cur->stack[cur->depth]++;
+
+      if(!sf->size || !sf->v)
+         continue;
+
+      if (sf->size == (uint32)~0)
+      {
+         if (cur->depth + 1 < SF_CURSOR_DEPTH)
+            cur->stack[++cur->depth] = (SFORMAT*)sf->v;
+         continue;
+      }
+
+      return sf;
+   }
+
+   return NULL;
+}
+
 static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
 {
    int temp = st->loc;
+   SFCursor cur;
+
+   cur.stack[0] = sf;
+   cur.depth    = 0;
 
    while (st->loc < (temp + size))
    {
@@ -257,7 +378,11 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
 
       smem_read32le(st, &recorded_size);
 
-      SFORMAT *tmp = FindSF((char*)toa + 1, sf);
+      /* Usually the next field in the table, only search when not */
+      SFORMAT *tmp = NextSF(&cur);
+
+      if(!tmp || strcmp(tmp->name, (char*)toa + 1))
+         tmp = FindSF((char*)toa + 1, sf);
 
       if(tmp)
       {
@@ -303,11 +428,104 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
    return 1;
 }
 
+/* Raw (data_only) states hold just the field data in table order, in
+ * native byte order, for snapshots that never leave this build. While
+ * MDFNSS_RawLayout() counts one, the section and field layout is hashed
+ * here so a snapshot can be checked against the running build. */
+static uint64_t *raw_layout;
+static const void *raw_find;
+static uint32_t raw_found;
+static const void *raw_skip;
+
+static void LayoutHash(const void *p, size_t len)
+{
+   const uint8_t *b = (const uint8_t*)p;
+
+   while(len--)
+      *raw_layout = (*raw_layout ^ *b++) * 0x100000001B3ULL;
+}
+
+static bool SubRaw(StateMem *st, SFORMAT *sf, int load)
+{
+   while(sf->size || sf->name)
+   {
+      if(!sf->size || !sf->v)
+      {
+         sf++;
+         continue;
+      }
+
+      if(sf->size == (uint32_t)~0)
+      {
+         if(!SubRaw(st, (SFORMAT *)sf->v, load))
+            return(0);
+
+         sf++;
+         continue;
+      }
+
+      if(sf->v == raw_skip)
+      {
+         sf++;
+         continue;
+      }
+
+      uint32_t bytesize = sf->size;
+
+      if(sf->flags & MDFNSTATE_BOOL)
+         bytesize *= sizeof(bool);
+
+      if(raw_find == sf->v)
+         raw_found = st->loc;
+
+      if(raw_layout)
+      {
+         LayoutHash(sf->name, strlen(sf->name) + 1);
+         LayoutHash(&bytesize, sizeof(bytesize));
+         LayoutHash(&sf->flags, sizeof(sf->flags));
+      }
+
+      if(load)
+      {
+         if(smem_read(st, sf->v, bytesize) != (int32_t)bytesize)
+            return(0);
+      }
+      else
+         smem_write(st, sf->v, bytesize);
+
+      sf++;
+   }
+
+   return true;
+}
+
 /* This function is called by the game driver(NES, GB, GBA) to save a state. */
 static int MDFNSS_StateAction_internal(void *st_p, int load, int data_only, SSDescriptor *section)
 {
    StateMem *st = (StateMem*)st_p;
 
+   if(data_only)
+   {
+      if(raw_layout)
+         LayoutHash(section->name, strlen(section->name) + 1);
+
+      return SubRaw(st, section->sf, load);
+   }
+
+   if(load && st->read)
+   {
+      char sname[32];
+      uint32_t tmp_size;
+
+      // Streamed sections have to come in the order they are asked for
+      if(smem_read(st, (uint8_t *)sname, 32) != 32 || smem_read32le(st, &tmp_size) != 4)
+         return(0);
+      if(strncmp(sname, section->name, 32))
+         return(0);
+
+      return ReadStateChunk(st, section->sf, tmp_size);
+   }
+
    if(load)
    {
       char sname[32];
@@ -360,7 +578,7 @@ int MDFNSS_StateAction(void *st_p, int load, int data_only, SFORMAT *sf, const c
    love.name     = name;
    love.optional = optional;
 
-   return(MDFNSS_StateAction_internal(st, load, 0, &love));
+   return(MDFNSS_StateAction_internal(st, load, data_only, &love));
 }
 
 int MDFNSS_SaveSM(void *st_p, int, int, const void*, const void*, const void*)
@@ -373,6 +591,15 @@ int MDFNSS_SaveSM(void *st_p, int, int, const void*, const void*, const void*)
    memset(header, 0, sizeof(header));
    memcpy(header, header_magic, 8);
 
+   if(st->write)
+   {
+      if(!stream_total)
+         return(0);
+
+      MDFN_en32lsb(header + 20, stream_total);
+      stream_next = 0;
+   }
+
    MDFN_en32lsb(header + 16, MEDNAFEN_VERSION_NUMERIC);
    MDFN_en32lsb(header + 24, neowidth);
    MDFN_en32lsb(header + 28, neoheight);
@@ -381,11 +608,14 @@ int MDFNSS_SaveSM(void *st_p, int, int, const void*, const void*, const void*)
    if(!StateAction(st, 0, 0))
       return(0);
 
+   if(st->write)
+      return !st->overflow && st->loc == stream_total;
+
    uint32_t sizy = st->loc;
    smem_seek(st, 16 + 4, SEEK_SET);
    smem_write32le(st, sizy);
 
-   return(1);
+   return !st->overflow;
 }
 
 int MDFNSS_LoadSM(void *st_p, int, int)
@@ -403,3 +633,91 @@ int MDFNSS_LoadSM(void *st_p, int, int)
 
    return StateAction(st, stateversion, 0);
 }
+
+uint32_t MDFNSS_CountSM(void)
+{
+   StateMem st;
+
+   memset(&st, 0, sizeof(st));
+   st.malloced = ~0U;
+   st.fixed    = 1;
+
+   stream_sections = 0;
+   stream_total    = 0;
+
+   stream_counting = true;
+   if(MDFNSS_SaveSM(&st, 0, 0, NULL, NULL, NULL))
+      stream_total = st.len;
+   stream_counting = false;
+
+   return stream_total;
+}
+
+uint64_t MDFNSS_RawLayout(uint32_t *size)
+{
+   StateMem st;
+   uint64_t layout = 0xCBF29CE484222325ULL;
+   const uint32_t build[3] = { MEDNAFEN_VERSION_NUMERIC, (uint32_t)sizeof(bool), 0x01020304 };
+
+   memset(&st, 0, sizeof(st));
+   st.malloced = ~0U;
+   st.fixed    = 1;
+
+   raw_layout = &layout;
+   LayoutHash(build, sizeof(build));
+   smem_write(&st, &layout, sizeof(layout));
+   StateAction(&st, 0, 1);
+   raw_layout = NULL;
+
+   *size = st.len;
+
+   return layout;
+}
+
+uint32_t MDFNSS_RawOffset(const void *v)
+{
+   StateMem st;
+   uint64_t layout = 0;
+
+   memset(&st, 0, sizeof(st));
+   st.malloced = ~0U;
+   st.fixed    = 1;
+
+   raw_find  = v;
+   raw_found = ~0U;
+   smem_write(&st, &layout, sizeof(layout));
+   StateAction(&st, 0, 1);
+   raw_find  = NULL;
+
+   return raw_found;
+}
+
+int MDFNSS_SaveRawSM(void *st_p, uint64_t layout, const void *skip)
+{
+   StateMem *st = (StateMem*)st_p;
+   int ret;
+
+   smem_write(st, &layout, sizeof(layout));
+
+   raw_skip = skip;
+   ret = StateAction(st, 0, 1);
+   raw_skip = NULL;
+
+   return ret && !st->overflow;
+}
+
+int MDFNSS_LoadRawSM(void *st_p, uint64_t layout, const void *skip)
+{
+   uint64_t recorded;
+   StateMem *st = (StateMem*)st_p;
+   int ret;
+
+   if(smem_read(st, &recorded, sizeof(recorded)) != sizeof(recorded) || recorded != layout)
+      return(0);
+
+   raw_skip = skip;
+   ret = StateAction(st, MEDNAFEN_VERSION_NUMERIC, 1);
+   raw_skip = NULL;
+
+   return ret;
+}
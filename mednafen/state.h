@@ -10,10 +10,35 @@ typedef struct
    uint32_t len;
    uint32_t malloced;
    uint32_t initial_malloc; // A setting!
+   uint32_t fixed;          // A setting! data is a caller buffer of malloced bytes, never reallocated,
+                            // or NULL to only count the bytes that would be written
+   uint32_t overflow;       // Set when a write did not fit a fixed buffer
+
+   // A setting! Streamed states go to write or come from read instead of
+   // data. Sections can then only be loaded in the order they were saved.
+   bool (*write)(void *opaque, const uint8_t *buffer, uint32_t len);
+   uint32_t (*read)(void *opaque, uint8_t *buffer, uint32_t len);
+   void *opaque;
 } StateMem;
 
 int MDFNSS_SaveSM(void *st, int, int, const void*, const void*, const void*);
 int MDFNSS_LoadSM(void *st, int, int);
+// Counts the bytes a save takes without writing anything, 0 if it fails.
+// Streamed saves write the section sizes found here, so one is counted
+// before them whenever the layout may have changed.
+uint32_t MDFNSS_CountSM(void);
+
+// Raw snapshots, only loadable by the build and game that saved them.
+// MDFNSS_RawLayout() returns the layout hash they are tagged with and
+// their size, both fixed once a game is loaded.
+uint64_t MDFNSS_RawLayout(uint32_t *size);
+// Where the field that saves v starts in a raw snapshot, ~0 if none does
+uint32_t MDFNSS_RawOffset(const void *v);
+// skip, if not NULL, is a field left out of the snapshot and untouched
+// by the load, the snapshot is then that much smaller than the
+// MDFNSS_RawLayout() size
+int MDFNSS_SaveRawSM(void *st, uint64_t layout, const void *skip = NULL);
+int MDFNSS_LoadRawSM(void *st, uint64_t layout, const void *skip = NULL);
 
 // Flag for a single, >= 1 byte native-endian variable
 #define MDFNSTATE_RLSB            0x80000000